@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include "microBmp.h"
+#include "microBmp_kernels.h"
 
 typedef struct bmp_RGB {
   uint8_t r;
@@ -30,24 +31,32 @@ inline static uint8_t popcount(uint32_t v)
 }
 
 
-inline static uint8_t stretchTo8bit(uint8_t v, uint8_t mask)
+/** 
+ * calculates shift, mask and the multiplier that replicates the top bits of a channel into the empty 
+ * low bits, so that ((((c16 >> shift) & mask) * mul) >> expShift) gives the exact 0..255 channel value.
+ * Channels wider than 8 bits are reduced to their 8 most significant bits
+ */
+static void microBmp_setupChannel16(uint32_t i_mask, uint8_t* o_shift, uint8_t* o_mask, uint8_t* o_mul, uint8_t* o_expShift)
 {
-  // 0001'1111  | pop = 5
-  // 1111'1000  | << 8-5
-  // (bits - (8-bits)) = bits - 8 + bits = 2*bits -8
-
-  // 0000'0011  2
-  // 1100'0000  6
-  //     
-
-  uint8_t bits = popcount(mask);
-  if (bits < 8) {
-    v = (v << (8 - bits));
-    //if (bits| (v >> (8 - ())
-    // todo: bill empty bits
+  uint8_t shift = i_mask ? trailingZeros(i_mask) : 0;
+  uint8_t bits  = popcount(i_mask);
+  uint8_t mul   = 0;
+  uint8_t total = 0;
+  if (bits > 8) {
+    shift += bits - 8;
+    bits   = 8;
+  }
+  if (bits) {
+    for (total = 0; total < 8; total += bits) {  // e.g. 5 bits: 0b100001, 10 bits -> >>2
+      mul = (uint8_t)((mul << bits) | 1);
+    }
   }
-  return v;
+  *o_shift    = shift;
+  *o_mask     = (uint8_t)((1u << bits) - 1);
+  *o_mul      = mul;
+  *o_expShift = bits ? (uint8_t)(total - 8) : 0;
 }
+
 static inline size_t calc_row_size(const microBmp_BmpInfo * dibHeader) {
   /* Weird formula because BMP row sizes are padded up to a multiple of 4 bytes. */
   return (((dibHeader->bitsPerPixel * dibHeader->imageWidth) + 31) / 32) * 4;
@@ -67,7 +76,705 @@ static bool  microBmp_checkSupportedCompression(const microBmp_BmpInfo* dibHeade
   ;
 }
 
+#ifdef MBMP_GENERIC_CONVERTERS
+
+/* one converter for all formats - smaller code but decides the format per pixel */
+
+static bmp_RGB microBmp_getColorAt(const microBmp_State* i_this, const uint8_t* i_row, uint16_t x)
+{
+  bmp_RGB col;
+  const uint8_t* coldata;
+  if (i_this->palette) {
+    uint32_t bitOff  = x * i_this->bitsPerPixel;
+    uint32_t byteOff = bitOff / 8;
+    uint32_t idx = i_row[byteOff];
+    if (i_this->bitsPerPixel == 4) { // multiple pixel per byte - refine index
+      if (x & 1) {
+        idx = idx & 0xf;
+      }else{
+        idx = idx >> 4;
+      }
+    } else if (i_this->bitsPerPixel == 1) { // multiple pixel per byte - refine index
+        idx = ((idx << (bitOff % 8)) & 0x80)?1:0;
+    }
+    coldata = &i_this->palette[idx * 4];
+    col.b = coldata[0];
+    col.g = coldata[1];
+    col.r = coldata[2];
+  } else if(i_this->bytesPerPixel == 2) {
+    uint16_t c16 = microBmp_read16(&i_row[x * 2]);
+    col.r = microBmp_expand16(c16, i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+    col.g = microBmp_expand16(c16, i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+    col.b = microBmp_expand16(c16, i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+
+  } else {
+    uint32_t byteOff = x * i_this->bytesPerPixel;
+    coldata = &i_row[byteOff];
+    col.b = coldata[0];
+    col.g = coldata[1];
+    col.r = coldata[2];
+  }
+  return col;
+}
+
+static void microBmp_genericToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  while (x1 < x2) {
+    bmp_RGB c = microBmp_getColorAt(i_this, i_row, x1);
+    o_targetBuf[0] = c.r;
+    o_targetBuf[1] = c.g;
+    o_targetBuf[2] = c.b;
+    o_targetBuf += 3;
+    ++x1;
+  }
+}
+
+static void microBmp_genericTo565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  while (x1 < x2) {
+    bmp_RGB c = microBmp_getColorAt(i_this, i_row, x1);
+    *o_targetBuf++ = microBmp_rgbTo565(c.r, c.g, c.b);
+    ++x1;
+  }
+}
+
+#else
+
+/* dedicated converters - one tight loop per source format */
+
+/** writes the BGRA palette entry idx as RGB and returns the next target position */
+static inline uint8_t* microBmp_putPaletteRGB(uint8_t* o_targetBuf, const uint8_t* i_palette, uint8_t idx)
+{
+  const uint8_t* c = &i_palette[idx * 4];
+  o_targetBuf[0] = c[2];
+  o_targetBuf[1] = c[1];
+  o_targetBuf[2] = c[0];
+  return o_targetBuf + 3;
+}
+
+/** returns the BGRA palette entry idx as RGB565 */
+static inline uint16_t microBmp_palette565(const uint8_t* i_palette, uint8_t idx)
+{
+  const uint8_t* c = &i_palette[idx * 4];
+  return microBmp_rgbTo565(c[2], c[1], c[0]);
+}
+
+/** writes the entry idx of a packed RGB palette table and returns the next target position */
+static inline uint8_t* microBmp_putLutRGB(uint8_t* o_targetBuf, const uint8_t* i_lut, uint8_t idx)
+{
+  const uint8_t* c = &i_lut[idx * 3];
+  o_targetBuf[0] = c[0];
+  o_targetBuf[1] = c[1];
+  o_targetBuf[2] = c[2];
+  return o_targetBuf + 3;
+}
+
+static void microBmp_index1ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 3];
+  const uint8_t* pal = i_this->palette;
+  uint8_t b;
+  if (x1 & 7) {                                  // pixels up to the next byte boundary
+    for (b = *src++; (x1 & 7) && (x1 < x2); ++x1) {
+      o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> (7 - (x1 & 7))) & 1);
+    }
+  }
+  for (; x1 + 8 <= x2; x1 += 8) {                // 8 pixels per byte
+    b = *src++;
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, b >> 7);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 6) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 5) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 4) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 3) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 2) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> 1) & 1);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, b & 1);
+  }
+  for (b = (x1 < x2) ? *src : 0; x1 < x2; ++x1) { // remaining pixels of the last byte
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, (b >> (7 - (x1 & 7))) & 1);
+  }
+}
+
+static void microBmp_index4ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 1];
+  const uint8_t* pal = i_this->palette;
+  if ((x1 & 1) && (x1 < x2)) {                   // odd start pixel uses the low nibble
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, *src++ & 0xF);
+    ++x1;
+  }
+  for (; x1 + 2 <= x2; x1 += 2) {                // 2 pixels per byte
+    uint8_t b = *src++;
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, b >> 4);
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, b & 0xF);
+  }
+  if (x1 < x2) {
+    o_targetBuf = microBmp_putPaletteRGB(o_targetBuf, pal, *src >> 4);
+  }
+}
+
+static void microBmp_index8ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1];
+  const uint8_t* pal = i_this->palette;
+  for (; x1 < x2; ++x1) {
+    const uint8_t* c = &pal[*src++ * 4];
+    o_targetBuf[0] = c[2];
+    o_targetBuf[1] = c[1];
+    o_targetBuf[2] = c[0];
+    o_targetBuf += 3;
+  }
+}
+
+static void microBmp_bitfield16ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    o_targetBuf[0] = microBmp_expand16(c16, i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+    o_targetBuf[1] = microBmp_expand16(c16, i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+    o_targetBuf[2] = microBmp_expand16(c16, i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+    o_targetBuf += 3;
+    src += 2;
+  }
+}
+
+static void microBmp_rgb565ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    o_targetBuf[0] = (uint8_t)((((c16 >> 11)       ) * 0x21) >> 2);
+    o_targetBuf[1] = (uint8_t)((((c16 >>  5) & 0x3F) * 0x41) >> 4);
+    o_targetBuf[2] = (uint8_t)((((c16      ) & 0x1F) * 0x21) >> 2);
+    o_targetBuf += 3;
+    src += 2;
+  }
+}
+
+static void microBmp_rgb555ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    o_targetBuf[0] = (uint8_t)((((c16 >> 10) & 0x1F) * 0x21) >> 2);
+    o_targetBuf[1] = (uint8_t)((((c16 >>  5) & 0x1F) * 0x21) >> 2);
+    o_targetBuf[2] = (uint8_t)((((c16      ) & 0x1F) * 0x21) >> 2);
+    o_targetBuf += 3;
+    src += 2;
+  }
+}
+
+static void microBmp_bgr24ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    o_targetBuf[0] = src[2];
+    o_targetBuf[1] = src[1];
+    o_targetBuf[2] = src[0];
+    o_targetBuf += 3;
+    src += 3;
+  }
+}
+
+static void microBmp_bgrx32ToRGB(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    o_targetBuf[0] = src[2];
+    o_targetBuf[1] = src[1];
+    o_targetBuf[2] = src[0];
+    o_targetBuf += 3;
+    src += 4;
+  }
+}
+
+static void microBmp_index1To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 3];
+  const uint8_t* pal = i_this->palette;
+  uint8_t b;
+  if (x1 & 7) {                                  // pixels up to the next byte boundary
+    for (b = *src++; (x1 & 7) && (x1 < x2); ++x1) {
+      *o_targetBuf++ = microBmp_palette565(pal, (b >> (7 - (x1 & 7))) & 1);
+    }
+  }
+  for (; x1 + 8 <= x2; x1 += 8) {                // 8 pixels per byte
+    b = *src++;
+    *o_targetBuf++ = microBmp_palette565(pal, b >> 7);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 6) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 5) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 4) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 3) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 2) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> 1) & 1);
+    *o_targetBuf++ = microBmp_palette565(pal, b & 1);
+  }
+  for (b = (x1 < x2) ? *src : 0; x1 < x2; ++x1) { // remaining pixels of the last byte
+    *o_targetBuf++ = microBmp_palette565(pal, (b >> (7 - (x1 & 7))) & 1);
+  }
+}
+
+static void microBmp_index4To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 1];
+  const uint8_t* pal = i_this->palette;
+  if ((x1 & 1) && (x1 < x2)) {                   // odd start pixel uses the low nibble
+    *o_targetBuf++ = microBmp_palette565(pal, *src++ & 0xF);
+    ++x1;
+  }
+  for (; x1 + 2 <= x2; x1 += 2) {                // 2 pixels per byte
+    uint8_t b = *src++;
+    *o_targetBuf++ = microBmp_palette565(pal, b >> 4);
+    *o_targetBuf++ = microBmp_palette565(pal, b & 0xF);
+  }
+  if (x1 < x2) {
+    *o_targetBuf++ = microBmp_palette565(pal, *src >> 4);
+  }
+}
+
+static void microBmp_index8To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1];
+  const uint8_t* pal = i_this->palette;
+  for (; x1 < x2; ++x1) {
+    const uint8_t* c = &pal[*src++ * 4];
+    *o_targetBuf++ = microBmp_rgbTo565(c[2], c[1], c[0]);
+  }
+}
+
+static void microBmp_bitfield16To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    *o_targetBuf++ = microBmp_rgbTo565(microBmp_expand16(c16, i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR),
+                                       microBmp_expand16(c16, i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG),
+                                       microBmp_expand16(c16, i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB));
+    src += 2;
+  }
+}
+
+/** source already is RGB565 - plain copy (byte swap on big endian hosts) */
+static void microBmp_rgb565To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  (void)i_this;
+  if (x1 >= x2) {
+    return;
+  }
+#ifdef MBMP_BIG_ENDIAN
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_read16(src);
+    src += 2;
+  }
+#else
+  memcpy(o_targetBuf, src, (size_t)(x2 - x1) * sizeof(uint16_t));
+#endif
+}
+
+/** shifts r and g one bit up and replicates the top green bit into the new lowest green bit */
+static void microBmp_rgb555To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    *o_targetBuf++ = (uint16_t)(((c16 & 0x7FE0) << 1) | ((c16 >> 4) & 0x0020) | (c16 & 0x001F));
+    src += 2;
+  }
+}
+
+static void microBmp_bgr24To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_rgbTo565(src[2], src[1], src[0]);
+    src += 3;
+  }
+}
+
+static void microBmp_bgrx32To565(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_rgbTo565(src[2], src[1], src[0]);
+    src += 4;
+  }
+}
+
+static void microBmp_index1ToRGBLut(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 3];
+  const uint8_t* lut = i_this->paletteLutRGB;
+  uint8_t b;
+  if (x1 & 7) {                                  // pixels up to the next byte boundary
+    for (b = *src++; (x1 & 7) && (x1 < x2); ++x1) {
+      o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> (7 - (x1 & 7))) & 1);
+    }
+  }
+  for (; x1 + 8 <= x2; x1 += 8) {                // 8 pixels per byte
+    b = *src++;
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, b >> 7);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 6) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 5) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 4) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 3) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 2) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> 1) & 1);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, b & 1);
+  }
+  for (b = (x1 < x2) ? *src : 0; x1 < x2; ++x1) { // remaining pixels of the last byte
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, (b >> (7 - (x1 & 7))) & 1);
+  }
+}
+
+static void microBmp_index4ToRGBLut(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 1];
+  const uint8_t* lut = i_this->paletteLutRGB;
+  if ((x1 & 1) && (x1 < x2)) {                   // odd start pixel uses the low nibble
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, *src++ & 0xF);
+    ++x1;
+  }
+  for (; x1 + 2 <= x2; x1 += 2) {                // 2 pixels per byte
+    uint8_t b = *src++;
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, b >> 4);
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, b & 0xF);
+  }
+  if (x1 < x2) {
+    o_targetBuf = microBmp_putLutRGB(o_targetBuf, lut, *src >> 4);
+  }
+}
+
+static void microBmp_index8ToRGBLut(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1];
+  const uint8_t* lut = i_this->paletteLutRGB;
+  for (; x1 < x2; ++x1) {
+    const uint8_t* c = &lut[*src++ * 3];
+    o_targetBuf[0] = c[0];
+    o_targetBuf[1] = c[1];
+    o_targetBuf[2] = c[2];
+    o_targetBuf += 3;
+  }
+}
+
+static void microBmp_index1To565Lut(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 3];
+  const uint16_t* lut = i_this->paletteLut565;
+  uint8_t b;
+  if (x1 & 7) {                                  // pixels up to the next byte boundary
+    for (b = *src++; (x1 & 7) && (x1 < x2); ++x1) {
+      *o_targetBuf++ = lut[(b >> (7 - (x1 & 7))) & 1];
+    }
+  }
+  for (; x1 + 8 <= x2; x1 += 8) {                // 8 pixels per byte
+    b = *src++;
+    *o_targetBuf++ = lut[b >> 7];
+    *o_targetBuf++ = lut[(b >> 6) & 1];
+    *o_targetBuf++ = lut[(b >> 5) & 1];
+    *o_targetBuf++ = lut[(b >> 4) & 1];
+    *o_targetBuf++ = lut[(b >> 3) & 1];
+    *o_targetBuf++ = lut[(b >> 2) & 1];
+    *o_targetBuf++ = lut[(b >> 1) & 1];
+    *o_targetBuf++ = lut[b & 1];
+  }
+  for (b = (x1 < x2) ? *src : 0; x1 < x2; ++x1) { // remaining pixels of the last byte
+    *o_targetBuf++ = lut[(b >> (7 - (x1 & 7))) & 1];
+  }
+}
+
+static void microBmp_index4To565Lut(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 >> 1];
+  const uint16_t* lut = i_this->paletteLut565;
+  if ((x1 & 1) && (x1 < x2)) {                   // odd start pixel uses the low nibble
+    *o_targetBuf++ = lut[*src++ & 0xF];
+    ++x1;
+  }
+  for (; x1 + 2 <= x2; x1 += 2) {                // 2 pixels per byte
+    uint8_t b = *src++;
+    *o_targetBuf++ = lut[b >> 4];
+    *o_targetBuf++ = lut[b & 0xF];
+  }
+  if (x1 < x2) {
+    *o_targetBuf++ = lut[*src >> 4];
+  }
+}
+
+static void microBmp_index8To565Lut(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t*  src = &i_row[x1];
+  const uint16_t* lut = i_this->paletteLut565;
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = lut[*src++];
+  }
+}
+
+/** converters indexed by microBmp_PixelFormat */
+static const microBmp_convertToRGBFunc s_convertToRGB[MBMP_PIXFMT_COUNT] = {
+  microBmp_index1ToRGB,
+  microBmp_index4ToRGB,
+  microBmp_index8ToRGB,
+  microBmp_bitfield16ToRGB,
+  microBmp_rgb565ToRGB,
+  microBmp_rgb555ToRGB,
+  microBmp_bgr24ToRGB,
+  microBmp_bgrx32ToRGB
+};
+
+/** converters indexed by microBmp_PixelFormat */
+static const microBmp_convertTo565Func s_convertTo565[MBMP_PIXFMT_COUNT] = {
+  microBmp_index1To565,
+  microBmp_index4To565,
+  microBmp_index8To565,
+  microBmp_bitfield16To565,
+  microBmp_rgb565To565,
+  microBmp_rgb555To565,
+  microBmp_bgr24To565,
+  microBmp_bgrx32To565
+};
+
+/** converters for indexed formats using the expanded palette, indexed by microBmp_PixelFormat */
+static const microBmp_convertToRGBFunc s_convertToRGBLut[MBMP_PIXFMT_BITFIELD16] = {
+  microBmp_index1ToRGBLut,
+  microBmp_index4ToRGBLut,
+  microBmp_index8ToRGBLut
+};
+
+/** converters for indexed formats using the expanded palette, indexed by microBmp_PixelFormat */
+static const microBmp_convertTo565Func s_convertTo565Lut[MBMP_PIXFMT_BITFIELD16] = {
+  microBmp_index1To565Lut,
+  microBmp_index4To565Lut,
+  microBmp_index8To565Lut
+};
+
+#endif
+
+/** 
+ * takes i_size bytes aligned to i_align from the front of the buffer
+ * \returns the taken part or NULL if the buffer is too small
+ */
+static uint8_t* microBmp_takeFromBuffer(uint8_t** io_buffer, size_t* io_buffersize, size_t i_size, size_t i_align)
+{
+  size_t   pad = (i_align - ((uintptr_t)*io_buffer % i_align)) % i_align;
+  uint8_t* ret = *io_buffer + pad;
+  if (pad + i_size > *io_buffersize) {
+    return NULL;
+  }
+  *io_buffer     += pad + i_size;
+  *io_buffersize -= pad + i_size;
+  return ret;
+}
+
+/** fills the requested palette lookup tables from the BGRA palette */
+static void microBmp_expandPalette(microBmp_State* io_this)
+{
+  const uint8_t* pal = io_this->palette;
+  uint16_t i;
+  for (i = 0; i < io_this->colorsInPalette; ++i, pal += 4) {
+    if (io_this->paletteLut565) {
+      io_this->paletteLut565[i] = microBmp_rgbTo565(pal[2], pal[1], pal[0]);
+    }
+    if (io_this->paletteLutRGB) {
+      io_this->paletteLutRGB[i * 3 + 0] = pal[2];
+      io_this->paletteLutRGB[i * 3 + 1] = pal[1];
+      io_this->paletteLutRGB[i * 3 + 2] = pal[0];
+    }
+  }
+}
+
+/** resolves the source format and picks the matching row converters */
+static void microBmp_selectConverters(microBmp_State* io_this, uint32_t i_flags)
+{
+  switch (io_this->bitsPerPixel) {
+    case 1:  io_this->pixelFormat = MBMP_PIXFMT_INDEX1;     break;
+    case 4:  io_this->pixelFormat = MBMP_PIXFMT_INDEX4;     break;
+    case 8:  io_this->pixelFormat = MBMP_PIXFMT_INDEX8;     break;
+    case 16:
+      io_this->pixelFormat = MBMP_PIXFMT_BITFIELD16;
+      if (    (io_this->shiftR == 11) && (io_this->maskR == 0x1F)
+           && (io_this->shiftG ==  5) && (io_this->maskG == 0x3F)
+           && (io_this->shiftB ==  0) && (io_this->maskB == 0x1F)) {
+        io_this->pixelFormat = MBMP_PIXFMT_RGB565;
+      } else if (    (io_this->shiftR == 10) && (io_this->maskR == 0x1F)
+                  && (io_this->shiftG ==  5) && (io_this->maskG == 0x1F)
+                  && (io_this->shiftB ==  0) && (io_this->maskB == 0x1F)) {
+        io_this->pixelFormat = MBMP_PIXFMT_RGB555;
+      }
+      break;
+    case 24: io_this->pixelFormat = MBMP_PIXFMT_BGR24;      break;
+    default: io_this->pixelFormat = MBMP_PIXFMT_BGRX32;     break;
+  }
+#ifdef MBMP_GENERIC_CONVERTERS
+  io_this->convertToRGB = microBmp_genericToRGB;
+  io_this->convertTo565 = microBmp_genericTo565;
+#else
+  io_this->convertToRGB = s_convertToRGB[io_this->pixelFormat];
+  io_this->convertTo565 = s_convertTo565[io_this->pixelFormat];
+  if (io_this->paletteLutRGB) {
+    io_this->convertToRGB = s_convertToRGBLut[io_this->pixelFormat];
+  }
+  if (io_this->paletteLut565) {
+    io_this->convertTo565 = s_convertTo565Lut[io_this->pixelFormat];
+  }
+#  ifdef MBMP_SIMD_X86
+  if (!(i_flags & MBMP_INIT_NO_SIMD)) {
+    microBmp_selectConvertersX86(io_this);
+  }
+#  endif
+#  ifdef MBMP_SIMD_NEON
+  if (!(i_flags & MBMP_INIT_NO_SIMD)) {
+    microBmp_selectConvertersNeon(io_this);
+  }
+#  endif
+#  ifdef MBMP_SIMD_SWAR
+  if (!(i_flags & MBMP_INIT_NO_SIMD)) {
+    microBmp_selectConvertersSwar(io_this);
+  }
+#  endif
+#endif
+  (void)i_flags;
+}
+
+/**
+ * "file" offset of the rows [i_first, i_first + i_count[ - the offset of the row that is stored first,
+ * that is i_first for top down images and the last one for bottom up images
+ */
+static uint32_t microBmp_rowsOffset(const microBmp_State* i_this, uint16_t i_first, uint16_t i_count)
+{
+  if (i_this->topDown) {
+    return i_this->endOfImage - i_this->bytesPerRow * (uint32_t)(i_this->imageHeight - i_first);
+  }
+  return i_this->endOfImage - i_this->bytesPerRow * (uint32_t)(i_first + i_count);
+}
+
+/** address difference from one image row to the next if rows of i_rowBytes bytes are stored in file order */
+static int32_t microBmp_fileOrderStride(const microBmp_State* i_this, uint32_t i_rowBytes)
+{
+  return i_this->topDown ? (int32_t)i_rowBytes : -(int32_t)i_rowBytes;
+}
+
+/** getNextRow walks from the last row upwards (file order of bottom up images) */
+static int microBmp_walksUp(const microBmp_State* i_this)
+{
+  return i_this->fileOrder && !i_this->topDown;
+}
+
+/** bytes a cache block may need for the widening of aligned loads in front of and behind its rows (see microBmp_setLoadAlignment) */
+static uint32_t microBmp_loadSlack(const microBmp_State* i_this)
+{
+  return (i_this->cachedRowBytes == i_this->bytesPerRow) ? i_this->loadAlignment - 1 : 0;
+}
+
+/**
+ * memory of cache block i_block. With a load alignment the blocks start at addresses that are multiples of it,
+ * so the widened fills can be read directly into the cache (e.g. by O_DIRECT or DMA)
+ */
+static uint8_t* microBmp_blockMem(const microBmp_State* i_this, uint8_t i_block)
+{
+  uint32_t a      = i_this->loadAlignment;
+  uint8_t* mem    = i_this->imageData;
+  size_t   stride = i_this->cacheSizeBytes;
+  if (microBmp_loadSlack(i_this)) {
+    mem    += (a - (uintptr_t)mem % a) % a;
+    stride += a - 1;
+    stride += (a - stride % a) % a;
+  }
+  return mem + (size_t)i_block * stride;
+}
+
+/**
+ * "file" range that is loaded for the complete rows [i_first, i_first + i_count[ - their bytes widened to multiples of
+ * loadAlignment, except that a range reaching the end of the image data ends exactly there.
+ * The rows are within the image, so the range never starts in front of the file.
+ * \returns number of bytes in front of the rows
+ */
+static uint32_t microBmp_fillRange(const microBmp_State* i_this, uint16_t i_first, uint16_t i_count, uint32_t* o_offset, uint32_t* o_numBytes)
+{
+  uint32_t offset = microBmp_rowsOffset(i_this, i_first, i_count);
+  uint32_t end    = offset + i_this->bytesPerRow * i_count;
+  uint32_t lead   = offset % i_this->loadAlignment;
+  uint32_t tail   = (i_this->loadAlignment - end % i_this->loadAlignment) % i_this->loadAlignment;
+  end = (tail < i_this->endOfImage - end) ? end + tail : i_this->endOfImage;
+  *o_offset   = offset - lead;
+  *o_numBytes = end - *o_offset;
+  return lead;
+}
+
+/**
+ * memory of the rows [i_first, i_first + i_count[ in cache block i_block (the first one in file order).
+ * Complete rows are loaded with their fill range (see microBmp_fillRange) to the start of the block,
+ * so they are stored behind its lead bytes.
+ */
+static uint8_t* microBmp_blockRows(const microBmp_State* i_this, uint8_t i_block, uint16_t i_first, uint16_t i_count)
+{
+  uint8_t* mem = microBmp_blockMem(i_this, i_block);
+  if (i_this->cachedRowBytes == i_this->bytesPerRow) {
+    uint32_t offset, numBytes;
+    mem += microBmp_fillRange(i_this, i_first, i_count, &offset, &numBytes);
+  }
+  return mem;
+}
+
+/**
+ * address of the first image row of the i_count rows at i_rows (see microBmp_blockRows) as used for rowData.
+ * With a column window the cached rows start at windowByteOffset, so the returned pointer is moved back by that offset
+ * to keep the pixel addressing of the row converters unchanged.
+ */
+static const uint8_t* microBmp_blockRowData(const microBmp_State* i_this, const uint8_t* i_rows, uint16_t i_count)
+{
+  if (i_this->topDown) {
+    return i_rows - i_this->windowByteOffset;
+  }
+  return i_rows + i_this->cachedRowBytes * (uint32_t)(i_count - 1) - i_this->windowByteOffset;
+}
+
+/**
+ * splits cacheBufferSize bytes at imageData into numCacheBlocks blocks of rows with cachedRowBytes each
+ * and invalidates all cached rows
+ */
+static microBmpStatus microBmp_layoutCache(microBmp_State* io_this)
+{
+  uint32_t slack      = microBmp_loadSlack(io_this);     // to align the first block, then twice per block (see microBmp_blockMem)
+  uint32_t blockBytes = (io_this->cacheBufferSize > slack) ? (io_this->cacheBufferSize - slack) / io_this->numCacheBlocks : 0;
+  uint32_t maxRows    = io_this->imageHeight ? io_this->imageHeight : 1;   // narrow windows would overflow the row counters
+  uint32_t fitRows    = (blockBytes > 2 * slack) ? (blockBytes - 2 * slack) / io_this->cachedRowBytes : 0;
+  uint16_t rows       = (uint16_t)((fitRows < maxRows) ? fitRows : maxRows);
+  uint8_t  i;
+  if (rows == 0) {
+    return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
+  }
+  io_this->cacheSizeRows  = rows;
+  io_this->cacheSizeBytes = (uint32_t)rows * io_this->cachedRowBytes;
+  io_this->rowStride      = microBmp_fileOrderStride(io_this, io_this->cachedRowBytes);
+  io_this->blockFirstRow  = 0;
+  io_this->blockRows      = 0;
+  io_this->blockData      = NULL;
+  for (i = 0; io_this->cacheBlocks && (i < io_this->numCacheBlocks); ++i) {
+    io_this->cacheBlocks[i].firstRow = 0;
+    io_this->cacheBlocks[i].rows     = 0;
+    io_this->cacheBlocks[i].stamp    = 0;
+  }
+  io_this->cachePolicyData = 0;
+  io_this->pendingBlock   = MBMP_NO_BLOCK;
+  return MBMP_STATUS_OK;
+}
+
 microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_loadDataFunc i_loadDataFunc, void* i_userData)
+{
+  return microBmp_initEx(o_this, io_buffer, i_buffersize, i_loadDataFunc, i_userData, MBMP_INIT_DEFAULT);
+}
+
+microBmpStatus microBmp_initEx(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_loadDataFunc i_loadDataFunc, void* i_userData, uint32_t i_flags)
 {
 
   if (i_buffersize < sizeof(microBmp_FileMetaData)){
@@ -75,6 +782,14 @@ microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t
   }
 
   o_this->loadDataFunc = i_loadDataFunc;
+  o_this->loadStridedFunc = NULL;
+  o_this->mapDataFunc = NULL;
+  o_this->startLoadFunc = NULL;
+  o_this->waitLoadFunc = NULL;
+  o_this->blitRowsDone = 0;
+  o_this->prefetchFunc = NULL;
+  o_this->loadPending = 0;
+  o_this->rowNotReady = 0;
   o_this->loadDataUserData = i_userData;
 
   /* load BMP meta data */
@@ -103,34 +818,39 @@ microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t
   }
 
   o_this->imageWidth = (uint16_t)dibHeader->imageWidth;
-  o_this->imageHeight = (uint16_t)dibHeader->imageHeight;
+  o_this->topDown = (dibHeader->imageHeight < 0);
+  o_this->imageHeight = (uint16_t)(o_this->topDown ? -dibHeader->imageHeight : dibHeader->imageHeight);
   o_this->bitsPerPixel     = (uint8_t)dibHeader->bitsPerPixel;
   o_this->bytesPerPixel    = o_this->bitsPerPixel / 8; 
   o_this->colorsInPalette = (uint16_t)dibHeader->colorsInPalette;
   o_this->palette = NULL;
+  o_this->paletteLut565 = NULL;
+  o_this->paletteLutRGB = NULL;
+  o_this->paletteSimd = NULL;
   o_this->bytesPerRow = calc_row_size(dibHeader);
-  o_this->endOfImage = (imgDataOffset + (uint32_t)o_this->bytesPerRow * dibHeader->imageHeight);
+  if ((uint64_t)imgDataOffset + (uint64_t)o_this->bytesPerRow * o_this->imageHeight > UINT32_MAX) {
+    return MBMP_STATUS_UNSUPPORTED_BMP_FORMAT;    // the row offsets would wrap to the front of the file
+  }
+  o_this->endOfImage = (imgDataOffset + (uint32_t)o_this->bytesPerRow * o_this->imageHeight);
 
 
   /* Calculating file constants */
   if (o_this->bitsPerPixel == 16) {
+    uint32_t maskR = 0x7C00;
+    uint32_t maskG = 0x03E0;
+    uint32_t maskB = 0x001F;
     if (dibHeader->compressionMethod == 3) {
-      o_this->shiftR = trailingZeros(dibHeader->maskR);
-      o_this->shiftG = trailingZeros(dibHeader->maskG);
-      o_this->shiftB = trailingZeros(dibHeader->maskB);
-      o_this->maskR  = (uint8_t)(dibHeader->maskR >> o_this->shiftR);
-      o_this->maskG  = (uint8_t)(dibHeader->maskG >> o_this->shiftG);
-      o_this->maskB  = (uint8_t)(dibHeader->maskB >> o_this->shiftB);
-    } else {
-      o_this->shiftR = 10;
-      o_this->shiftG =  5;
-      o_this->shiftB =  0;
-      o_this->maskR = 0x1F;
-      o_this->maskG = 0x1F;
-      o_this->maskB = 0x1F;
+      maskR = dibHeader->maskR & 0xFFFF;
+      maskG = dibHeader->maskG & 0xFFFF;
+      maskB = dibHeader->maskB & 0xFFFF;
     }
+    microBmp_setupChannel16(maskR, &o_this->shiftR, &o_this->maskR, &o_this->expMulR, &o_this->expShiftR);
+    microBmp_setupChannel16(maskG, &o_this->shiftG, &o_this->maskG, &o_this->expMulG, &o_this->expShiftG);
+    microBmp_setupChannel16(maskB, &o_this->shiftB, &o_this->maskB, &o_this->expMulB, &o_this->expShiftB);
   }
-  o_this->currentRow = 0;
+  o_this->fileOrder = (i_flags & MBMP_INIT_FILE_ORDER) != 0;
+  o_this->currentRow = microBmp_walksUp(o_this) ? o_this->imageHeight : 0;
+  o_this->rowY = 0;
 
   if (o_this->bitsPerPixel <= 8) {                      // palette image use part of buffer as palette buffer and rest as data cache
     uint32_t paletteOffset = sizeof(microBmp_FileHeader) + dibHeader->headerSize;
@@ -143,10 +863,29 @@ microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t
     uint32_t reqMinBuffersize = paletteSize + o_this->bytesPerRow;
     if (reqMinBuffersize <= i_buffersize) {
       if (i_loadDataFunc) {
-        o_this->palette = io_buffer;
-        io_buffer     += paletteSize;
-        i_buffersize -= paletteSize;
+        o_this->palette = microBmp_takeFromBuffer(&io_buffer, &i_buffersize, paletteSize, 1);
         i_loadDataFunc(o_this->palette, paletteSize, paletteOffset, i_userData);
+        if (i_flags & MBMP_INIT_PALETTE_LUT_565) {
+          o_this->paletteLut565 = (uint16_t*)microBmp_takeFromBuffer(&io_buffer, &i_buffersize, o_this->colorsInPalette * sizeof(uint16_t), sizeof(uint16_t));
+          if (o_this->paletteLut565 == NULL) {
+            return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
+          }
+        }
+        if (i_flags & MBMP_INIT_PALETTE_LUT_RGB) {
+          o_this->paletteLutRGB = microBmp_takeFromBuffer(&io_buffer, &i_buffersize, o_this->colorsInPalette * 3, 1);
+          if (o_this->paletteLutRGB == NULL) {
+            return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
+          }
+        }
+#ifdef MBMP_SIMD_X86
+        {
+          size_t simdBytes = (i_flags & MBMP_INIT_NO_SIMD) ? 0 : microBmp_x86PaletteBytes(o_this);
+          if (simdBytes && (i_buffersize >= simdBytes + 15 + o_this->bytesPerRow)) {   // optional - never at the cost of the last cached row
+            o_this->paletteSimd = microBmp_takeFromBuffer(&io_buffer, &i_buffersize, simdBytes, 16);
+          }
+        }
+#endif
+        microBmp_expandPalette(o_this);
       } else {
         o_this->palette = io_buffer + paletteOffset;
       }
@@ -155,121 +894,798 @@ microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t
       return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
     }
   }
+  microBmp_selectConverters(o_this, i_flags);
 
   o_this->cachedRows = 0;
-  o_this->cacheSizeRows = (uint16_t)( i_buffersize/o_this->bytesPerRow);
-  o_this->cacheSizeBytes = o_this->cacheSizeRows * o_this->bytesPerRow;
   o_this->imageData = io_buffer;
+  o_this->cacheBufferSize = (uint32_t)i_buffersize;
+  o_this->cachedRowBytes = o_this->bytesPerRow;
+  o_this->windowByteOffset = 0;
+  o_this->cacheBlocks = NULL;
+  o_this->cachePolicy = NULL;
+  o_this->cachePolicyData = 0;
+  o_this->numCacheBlocks = 1;
+  o_this->cacheHits = 0;
+  o_this->cacheMisses = 0;
+  o_this->prefetchEndRow = o_this->imageHeight;
+  o_this->loadAlignment = 1;
 
-  if (o_this->cacheSizeRows == 0 || o_this->imageData == NULL) {
+  if (o_this->imageData == NULL || microBmp_layoutCache(o_this) != MBMP_STATUS_OK) {
     return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
   }
 
+  if (!i_loadDataFunc) {                          // the whole image is in memory - one block holding all rows
+    o_this->blockFirstRow = 0;
+    o_this->blockRows = o_this->imageHeight;
+    o_this->blockData = o_this->imageData + microBmp_rowsOffset(o_this, 0, 1);
+  }
+
   return MBMP_STATUS_OK;
 }
 
+/** source of microBmp_initPrefix - the first bytes of the file are in memory already */
+typedef struct {
+  const uint8_t*        head;                 /**< file bytes [0, headBytes[ (headers and palette) */
+  uint32_t              headBytes;
+  const uint8_t*        data;                 /**< file bytes [headBytes, headBytes + dataBytes[ (image data) */
+  uint32_t              dataBytes;
+  microBmp_loadDataFunc loadDataFunc;
+  void*                 userData;
+} microBmp_PrefixSource;
 
-const uint8_t* microBmp_getNextRow(microBmp_State * io_this) 
+/** microBmp_loadDataFunc that serves the loads of microBmp_initEx from the prefix as far as possible */
+static void microBmp_prefixLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
 {
-  if (io_this->currentRow == io_this->imageHeight) {
-    return NULL;
-  }
-  if(io_this->cachedRows == 0)
-  {
-    if (io_this->loadDataFunc) {
-      /* BMP stores image data backwards, counting back to the row we want to start the read at. */
-      uint32_t offset = io_this->endOfImage - (uint32_t)io_this->bytesPerRow * (uint32_t)(io_this->currentRow + io_this->cacheSizeRows);
-      io_this->loadDataFunc(io_this->imageData, io_this->cacheSizeBytes, offset, io_this->loadDataUserData);
-      io_this->cachedRows = io_this->cacheSizeRows;
-      /* Move the row pointer forward to the start of the last row **/
-      io_this->rowData = io_this->imageData + (io_this->bytesPerRow) * (io_this->cacheSizeRows - 1);
+  const microBmp_PrefixSource* src = (const microBmp_PrefixSource*)io_userData;
+  uint8_t*                     dst = (uint8_t*)o_buffer;
+  while (i_numBytes > 0) {
+    const uint8_t* from;
+    uint32_t       n;
+    if (i_offset < src->headBytes) {
+      from = src->head + i_offset;
+      n    = src->headBytes - i_offset;
+    } else if (i_offset - src->headBytes < src->dataBytes) {
+      from = src->data + (i_offset - src->headBytes);
+      n    = src->dataBytes - (i_offset - src->headBytes);
     } else {
-      uint32_t offset = io_this->endOfImage - (uint32_t)io_this->bytesPerRow * (uint32_t)(io_this->currentRow+1);
-      io_this->rowData = io_this->imageData + offset;
-      io_this->cachedRows = 1;
+      src->loadDataFunc(dst, i_numBytes, i_offset, src->userData);
+      return;
+    }
+    if (n > i_numBytes) {
+      n = i_numBytes;
     }
+    memmove(dst, from, n);                        // e.g. the palette moves to the front of the buffer
+    dst        += n;
+    i_offset   += n;
+    i_numBytes -= n;
+  }
+}
 
+microBmpStatus microBmp_initPrefix(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, uint32_t i_prefixBytes,
+                                   microBmp_loadDataFunc i_loadDataFunc, void* i_userData, uint32_t i_flags)
+{
+  microBmp_PrefixSource src;
+  microBmpStatus        status;
+  uint32_t              dataOffset, dataBytes, first, rows;
+  uint8_t*              mem;
+  if (!i_loadDataFunc || (i_buffersize < sizeof(microBmp_FileMetaData))) {
+    return microBmp_initEx(o_this, io_buffer, i_buffersize, i_loadDataFunc, i_userData, i_flags);
   }
-  else
-  {
-    /* Moving down a row (which is backwards in memory)
-       RowData is in 2 byte chunks (uint16), rowSize in bytes. Divide by 2. */
-    io_this->rowData -= io_this->bytesPerRow;
+  if (i_prefixBytes > i_buffersize) {
+    i_prefixBytes = (uint32_t)i_buffersize;
+  }
+  i_loadDataFunc(io_buffer, i_prefixBytes, 0, i_userData);
+
+  /* the image data of the prefix is moved to the end of the buffer, so palette and lookup tables do not overwrite it */
+  src.head         = io_buffer;
+  src.headBytes    = i_prefixBytes;
+  src.dataBytes    = 0;
+  src.loadDataFunc = i_loadDataFunc;
+  src.userData     = i_userData;
+  if (i_prefixBytes >= sizeof(microBmp_FileHeader)) {
+    dataOffset = ((const microBmp_FileHeader*)io_buffer)->imageDataOffset;
+    if (dataOffset < i_prefixBytes) {
+      src.headBytes = dataOffset;
+      src.dataBytes = i_prefixBytes - dataOffset;
+    }
+  }
+  if (src.dataBytes > i_buffersize - sizeof(microBmp_FileMetaData)) {  // initEx reads the headers to the front of the buffer
+    src.dataBytes = (uint32_t)(i_buffersize - sizeof(microBmp_FileMetaData));
   }
-  --io_this->cachedRows;
-  io_this->currentRow += 1;
-  return  io_this->rowData;
+  src.data = io_buffer + i_buffersize - src.dataBytes;
+  memmove((uint8_t*)src.data, io_buffer + src.headBytes, src.dataBytes);
+
+  status = microBmp_initEx(o_this, io_buffer, i_buffersize, microBmp_prefixLoad, &src, i_flags);
+  o_this->loadDataFunc     = i_loadDataFunc;
+  o_this->loadDataUserData = i_userData;
+  if ((status != MBMP_STATUS_OK) || (o_this->bytesPerRow == 0)) {
+    return status;
+  }
+
+  /* keep the complete rows of the prefix as cache block (without the ones the lookup tables reach into) */
+  dataOffset = o_this->endOfImage - o_this->bytesPerRow * o_this->imageHeight;
+  dataBytes  = (dataOffset == src.headBytes) ? src.dataBytes : 0;
+  if (dataBytes > o_this->endOfImage - dataOffset) {
+    dataBytes = o_this->endOfImage - dataOffset;
+  }
+  first = 0;                                      // first row of the copy (in file order) behind palette and lookup tables
+  if (o_this->imageData > src.data) {
+    first = ((uint32_t)(o_this->imageData - src.data) + o_this->bytesPerRow - 1) / o_this->bytesPerRow;
+  }
+  rows  = dataBytes / o_this->bytesPerRow;
+  if (rows <= first) {
+    return MBMP_STATUS_OK;
+  }
+  rows -= first;
+  if (rows > o_this->cacheSizeRows) {
+    rows = o_this->cacheSizeRows;
+  }
+  o_this->blockFirstRow = (uint16_t)(o_this->topDown ? first : o_this->imageHeight - first - rows);
+  o_this->blockRows     = (uint16_t)rows;
+  mem = microBmp_blockRows(o_this, 0, o_this->blockFirstRow, o_this->blockRows);
+  memmove(mem, src.data + (size_t)first * o_this->bytesPerRow, (size_t)rows * o_this->bytesPerRow);
+  o_this->blockData     = microBmp_blockRowData(o_this, mem, o_this->blockRows);
+  return MBMP_STATUS_OK;
 }
 
-void microBmp_setNextRow(microBmp_State* io_this, uint16_t row)
+microBmpStatus microBmp_initFeed(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_rowFunc i_rowFunc, void* i_userData, uint32_t i_flags)
+{
+  if ((io_buffer == NULL) || (i_buffersize < sizeof(microBmp_FileMetaData))) {
+    return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
+  }
+  o_this->rowFunc          = i_rowFunc;
+  o_this->loadDataUserData = i_userData;
+  o_this->feedFlags        = i_flags & ~(uint32_t)MBMP_INIT_FILE_ORDER;
+  o_this->feedFill         = 0;
+  o_this->feedPhase        = MBMP_FEED_HEADER;
+  o_this->feedStatus       = MBMP_STATUS_OK;
+  o_this->imageData        = io_buffer;            // the headers are collected here
+  o_this->cacheBufferSize  = (uint32_t)i_buffersize;
+  o_this->imageWidth       = 0;
+  o_this->imageHeight      = 0;
+  o_this->currentRow       = 0;
+  o_this->rowY             = 0;
+  o_this->rowData          = NULL;
+  return MBMP_STATUS_OK;
+}
+
+/**
+ * microBmp_loadDataFunc of the push mode - serves microBmp_initEx from the collected headers
+ * (imageData is still the start of the buffer then), everything else reads as zero
+ */
+static void microBmp_feedLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
 {
-  /** \todo do not invalidate all cash rows if not necessary */
-  io_this->currentRow = row;
-  io_this->cachedRows = 0;
+  const microBmp_State* state = (const microBmp_State*)io_userData;
+  uint32_t              n     = 0;
+  if ((state->feedPhase == MBMP_FEED_HEADER) && (i_offset < state->feedFill)) {
+    n = state->feedFill - i_offset;
+    if (n > i_numBytes) {
+      n = i_numBytes;
+    }
+    memmove(o_buffer, state->imageData + i_offset, n);   // the palette moves to the front of the buffer
+  }
+  memset((uint8_t*)o_buffer + n, 0, i_numBytes - n);
 }
 
+/** stops the push mode with i_status */
+static microBmpStatus microBmp_feedFail(microBmp_State* io_this, microBmpStatus i_status)
+{
+  io_this->feedPhase  = MBMP_FEED_FAILED;
+  io_this->feedStatus = (uint8_t)i_status;
+  return i_status;
+}
 
-static bmp_RGB microBmp_getColorAt(const microBmp_State* i_this, uint16_t x)
+/**
+ * collects the bytes up to the image data (headers and palette) and initializes the state from them
+ * \returns MBMP_STATUS_OK also if more bytes are required
+ */
+static microBmpStatus microBmp_feedHeader(microBmp_State* io_this, const uint8_t** io_data, size_t* io_numBytes)
 {
-  bmp_RGB col;
-  const uint8_t* coldata;
-  if (i_this->palette) {
-    uint32_t bitOff  = x * i_this->bitsPerPixel;
-    uint32_t byteOff = bitOff / 8;
-    uint32_t idx = i_this->rowData[byteOff];
-    if (i_this->bitsPerPixel == 4) { // multiple pixel per byte - refine index
-      if (x & 1) {
-        idx = idx & 0xf;
-      }else{
-        idx = idx >> 4;
+  void*          userData = io_this->loadDataUserData;
+  microBmpStatus status;
+  for (;;) {
+    uint32_t need = sizeof(microBmp_FileHeader);
+    uint32_t n;
+    if (io_this->feedFill >= need) {              // the file header tells where the image data starts
+      const microBmp_FileHeader* fileheader = (const microBmp_FileHeader*)io_this->imageData;
+      if (fileheader->fileIdentifier != 19778) {
+        return microBmp_feedFail(io_this, MBMP_STATUS_UNSUPPORTED_FILE_TYPE);
+      }
+      need = fileheader->imageDataOffset;
+      if (need < sizeof(microBmp_FileHeader)) {
+        return microBmp_feedFail(io_this, MBMP_STATUS_UNSUPPORTED_BMP_FORMAT);
+      }
+      if (need > io_this->cacheBufferSize) {
+        return microBmp_feedFail(io_this, MBMP_STATUS_CACHE_BUFFER_TOO_SMALL);
+      }
+      if (io_this->feedFill == need) {
+        break;
       }
-    } else if (i_this->bitsPerPixel == 1) { // multiple pixel per byte - refine index
-        idx = ((idx << (bitOff % 8)) & 0x80)?1:0;
     }
-    coldata = &i_this->palette[idx * 4];
-    col.b = coldata[0];
-    col.g = coldata[1];
-    col.r = coldata[2];
-  } else if(i_this->bytesPerPixel == 2) {
-    const uint16_t* u16Row = (const uint16_t*)i_this->rowData;
-    uint16_t c16 = u16Row[x];
-    col.r = stretchTo8bit((c16 >> i_this->shiftR)& i_this->maskR, i_this->maskR);
-    col.g = stretchTo8bit((c16 >> i_this->shiftG)& i_this->maskG, i_this->maskG);
-    col.b = stretchTo8bit((c16 >> i_this->shiftB)& i_this->maskB, i_this->maskB);
+    if (*io_numBytes == 0) {
+      return MBMP_STATUS_OK;
+    }
+    n = need - io_this->feedFill;
+    if (n > *io_numBytes) {
+      n = (uint32_t)*io_numBytes;
+    }
+    memcpy(io_this->imageData + io_this->feedFill, *io_data, n);
+    io_this->feedFill += n;
+    *io_data          += n;
+    *io_numBytes      -= n;
+  }
+
+  status = microBmp_initEx(io_this, io_this->imageData, io_this->cacheBufferSize, microBmp_feedLoad, io_this, io_this->feedFlags);
+  io_this->loadDataUserData = userData;
+  if (status != MBMP_STATUS_OK) {
+    return microBmp_feedFail(io_this, status);
+  }
+  io_this->feedFill  = 0;
+  io_this->feedPhase = (io_this->imageHeight > 0) ? MBMP_FEED_ROWS : MBMP_FEED_DONE;
+  return MBMP_STATUS_OK;
+}
 
+/** passes the next row of the file on to the rowFunc */
+static void microBmp_feedRow(microBmp_State* io_this, const uint8_t* i_row)
+{
+  io_this->rowY    = io_this->topDown ? io_this->currentRow : (uint16_t)(io_this->imageHeight - 1 - io_this->currentRow);
+  io_this->rowData = i_row;
+  ++io_this->currentRow;
+  if (io_this->currentRow == io_this->imageHeight) {
+    io_this->feedPhase = MBMP_FEED_DONE;
+  }
+  if (io_this->rowFunc) {
+    io_this->rowFunc(io_this, i_row, io_this->rowY, io_this->loadDataUserData);
+  }
+}
+
+microBmpStatus microBmp_feed(microBmp_State* io_this, const uint8_t* i_data, size_t i_numBytes)
+{
+  if (io_this->feedPhase == MBMP_FEED_FAILED) {
+    return (microBmpStatus)io_this->feedStatus;
+  }
+  if (io_this->feedPhase == MBMP_FEED_HEADER) {
+    microBmpStatus status = microBmp_feedHeader(io_this, &i_data, &i_numBytes);
+    if (status != MBMP_STATUS_OK) {
+      return status;
+    }
+  }
+  while ((io_this->feedPhase == MBMP_FEED_ROWS) && (i_numBytes > 0)) {
+    const uint8_t* row = i_data;
+    if ((io_this->feedFill > 0) || (i_numBytes < io_this->bytesPerRow)) {   // collect the partial row in the buffer
+      uint32_t n = io_this->bytesPerRow - io_this->feedFill;
+      if (n > i_numBytes) {
+        n = (uint32_t)i_numBytes;
+      }
+      memcpy(io_this->imageData + io_this->feedFill, i_data, n);
+      io_this->feedFill += n;
+      i_data            += n;
+      i_numBytes        -= n;
+      if (io_this->feedFill < io_this->bytesPerRow) {
+        break;
+      }
+      row               = io_this->imageData;
+      io_this->feedFill = 0;
+    } else {                                       // complete row within the passed bytes - used in place
+      i_data     += io_this->bytesPerRow;
+      i_numBytes -= io_this->bytesPerRow;
+    }
+    microBmp_feedRow(io_this, row);
+  }
+  return MBMP_STATUS_OK;
+}
+
+
+static void microBmp_lruTouch(microBmp_State* io_this, uint8_t i_block)
+{
+  io_this->cacheBlocks[i_block].stamp = ++io_this->cachePolicyData;
+}
+
+static uint8_t microBmp_lruVictim(microBmp_State* io_this)
+{
+  uint8_t victim = 0;
+  uint8_t i;
+  for (i = 1; i < io_this->numCacheBlocks; ++i) {
+    if (io_this->cacheBlocks[i].stamp < io_this->cacheBlocks[victim].stamp) {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+static void microBmp_clockTouch(microBmp_State* io_this, uint8_t i_block)
+{
+  io_this->cacheBlocks[i_block].stamp = 1;
+}
+
+static uint8_t microBmp_clockVictim(microBmp_State* io_this)
+{
+  for (;;) {
+    uint8_t hand = (uint8_t)io_this->cachePolicyData;
+    io_this->cachePolicyData = (hand + 1u) % io_this->numCacheBlocks;
+    if (io_this->cacheBlocks[hand].stamp == 0) {
+      return hand;
+    }
+    io_this->cacheBlocks[hand].stamp = 0;   // second chance
+  }
+}
+
+const microBmp_CachePolicy microBmp_cachePolicyLRU   = { microBmp_lruTouch,   microBmp_lruVictim };
+const microBmp_CachePolicy microBmp_cachePolicyClock = { microBmp_clockTouch, microBmp_clockVictim };
+
+
+microBmpStatus microBmp_setupCache(microBmp_State* io_this, uint8_t i_numBlocks, const microBmp_CachePolicy* i_policy)
+{
+  uint8_t*             buffer     = io_this->imageData;
+  size_t               buffersize = io_this->cacheBufferSize;
+  microBmp_CacheBlock* blocks;
+  if (!io_this->loadDataFunc) {
+    return MBMP_STATUS_OK;
+  }
+  if (i_numBlocks == 0) {
+    i_numBlocks = 1;
+  }
+  blocks = (microBmp_CacheBlock*)microBmp_takeFromBuffer(&buffer, &buffersize, i_numBlocks * sizeof(microBmp_CacheBlock), sizeof(uint32_t));
+  if ((blocks == NULL) || (buffersize / i_numBlocks / io_this->cachedRowBytes == 0)) {
+    return MBMP_STATUS_CACHE_BUFFER_TOO_SMALL;
+  }
+  io_this->cacheBlocks     = blocks;
+  io_this->cachePolicy     = i_policy ? i_policy : &microBmp_cachePolicyLRU;
+  io_this->numCacheBlocks  = i_numBlocks;
+  io_this->imageData       = buffer;
+  io_this->cacheBufferSize = (uint32_t)buffersize;
+  return microBmp_layoutCache(io_this);
+}
+
+microBmpStatus microBmp_setAsyncLoad(microBmp_State* io_this, microBmp_startLoadFunc i_startLoadFunc)
+{
+  microBmpStatus status = microBmp_setupCache(io_this, 2, &microBmp_cachePolicyLRU);
+  if ((status == MBMP_STATUS_OK) && io_this->loadDataFunc) {
+    io_this->startLoadFunc = i_startLoadFunc;
+  }
+  return status;
+}
+
+microBmpStatus microBmp_setLoadAlignment(microBmp_State* io_this, uint32_t i_blockSize)
+{
+  if (!io_this->loadDataFunc) {
+    return MBMP_STATUS_OK;
+  }
+  io_this->loadAlignment = (i_blockSize > 0) ? i_blockSize : 1;
+  return microBmp_layoutCache(io_this);
+}
+
+microBmpStatus microBmp_setColumnWindow(microBmp_State* io_this, uint16_t i_x1, uint16_t i_x2)
+{
+  if (!io_this->loadDataFunc) {
+    return MBMP_STATUS_OK;
+  }
+  if (i_x2 > io_this->imageWidth) {
+    i_x2 = io_this->imageWidth;
+  }
+  if ((i_x1 >= i_x2) || ((i_x1 == 0) && (i_x2 == io_this->imageWidth))) {
+    io_this->windowByteOffset = 0;
+    io_this->cachedRowBytes   = io_this->bytesPerRow;
+  } else {                                        // whole bytes that hold the pixels of the window
+    io_this->windowByteOffset = ((uint32_t)i_x1 * io_this->bitsPerPixel) / 8;
+    io_this->cachedRowBytes   = ((uint32_t)i_x2 * io_this->bitsPerPixel + 7) / 8 - io_this->windowByteOffset;
+  }
+  return microBmp_layoutCache(io_this);
+}
+
+
+/**
+ * loads i_firstRow and the following rows into a cache block (the victim of the cache policy if there are several)
+ * and makes it the current block.
+ * BMP stores image data backwards, so row i_firstRow ends up at the end of the block
+ */
+static void microBmp_loadBlock(microBmp_State* io_this, uint16_t i_firstRow)
+{
+  uint8_t  block = 0;
+  uint8_t* rows;                                  // memory of the first row in file order
+  uint32_t offset;
+  if (io_this->cacheBlocks) {
+    block = io_this->cachePolicy->victim(io_this);
+  }
+  io_this->blockFirstRow = i_firstRow;
+  io_this->blockRows     = io_this->cacheSizeRows;
+  if (io_this->blockRows > io_this->imageHeight - i_firstRow) {
+    io_this->blockRows = (uint16_t)(io_this->imageHeight - i_firstRow);
+  }
+  rows   = microBmp_blockRows(io_this, block, i_firstRow, io_this->blockRows);
+  offset = microBmp_rowsOffset(io_this, i_firstRow, io_this->blockRows);
+  if (io_this->cachedRowBytes == io_this->bytesPerRow) {  // only the rows of the block, the last one is not filled up
+    uint32_t numBytes;
+    uint32_t lead = microBmp_fillRange(io_this, i_firstRow, io_this->blockRows, &offset, &numBytes);
+    io_this->loadDataFunc(rows - lead, numBytes, offset, io_this->loadDataUserData);
+  } else if (io_this->loadStridedFunc) {          // column window - the cached rows are not contiguous in the file
+    io_this->loadStridedFunc(rows, io_this->cachedRowBytes, io_this->blockRows, offset + io_this->windowByteOffset,
+                             io_this->bytesPerRow, io_this->cachedRowBytes, io_this->loadDataUserData);
   } else {
-    uint32_t byteOff = x * i_this->bytesPerPixel;
-    coldata = &i_this->rowData[byteOff];
-    col.b = coldata[0];
-    col.g = coldata[1];
-    col.r = coldata[2];
+    uint16_t k;
+    for (k = 0; k < io_this->blockRows; ++k) {
+      io_this->loadDataFunc(rows + (size_t)k * io_this->cachedRowBytes, io_this->cachedRowBytes,
+                            offset + (uint32_t)k * io_this->bytesPerRow + io_this->windowByteOffset, io_this->loadDataUserData);
+    }
+  }
+  io_this->blockData = microBmp_blockRowData(io_this, rows, io_this->blockRows);
+  io_this->rowStride = microBmp_fileOrderStride(io_this, io_this->cachedRowBytes);
+  if (io_this->cacheBlocks) {
+    io_this->cacheBlocks[block].firstRow = io_this->blockFirstRow;
+    io_this->cacheBlocks[block].rows     = io_this->blockRows;
+    io_this->cachePolicy->touch(io_this, block);
   }
-  return col;
 }
 
-void microBmp_convertRowToRGB(const microBmp_State* i_this, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2) {
-  while (x1 < x2) {
-    bmp_RGB c = microBmp_getColorAt(i_this, x1);
-    o_targetBuf[0] = c.r;
-    o_targetBuf[1] = c.g;
-    o_targetBuf[2] = c.b;
-    o_targetBuf += 3;
-    ++x1;
+/** returns the index of the cache block that holds i_row or MBMP_NO_BLOCK */
+static uint8_t microBmp_findCachedBlock(const microBmp_State* i_this, uint16_t i_row)
+{
+  uint8_t i;
+  for (i = 0; i_this->cacheBlocks && (i < i_this->numCacheBlocks); ++i) {
+    const microBmp_CacheBlock* b = &i_this->cacheBlocks[i];
+    if ((i_row >= b->firstRow) && (i_row - b->firstRow < b->rows)) {
+      return i;
+    }
+  }
+  return MBMP_NO_BLOCK;
+}
+
+/** makes the cache block that holds i_row the current block, returns 0 if no block holds it */
+static int microBmp_selectCachedBlock(microBmp_State* io_this, uint16_t i_row)
+{
+  uint8_t i = microBmp_findCachedBlock(io_this, i_row);
+  if (i == MBMP_NO_BLOCK) {
+    return 0;
+  }
+  io_this->blockFirstRow = io_this->cacheBlocks[i].firstRow;
+  io_this->blockRows     = io_this->cacheBlocks[i].rows;
+  io_this->blockData     = microBmp_blockRowData(io_this, microBmp_blockRows(io_this, i, io_this->blockFirstRow, io_this->blockRows),
+                                                 io_this->blockRows);
+  io_this->rowStride     = microBmp_fileOrderStride(io_this, io_this->cachedRowBytes);
+  io_this->cachePolicy->touch(io_this, i);
+  return 1;
+}
+
+/** starts the asynchronous load of i_firstRow and the following rows into the cache block that is not in use */
+static void microBmp_startLoad(microBmp_State* io_this, uint16_t i_firstRow)
+{
+  uint8_t  block = io_this->cachePolicy->victim(io_this);
+  uint16_t rows  = io_this->cacheSizeRows;
+  uint8_t* mem;
+  uint32_t offset, numBytes, lead;
+  if (rows > io_this->imageHeight - i_firstRow) {
+    rows = (uint16_t)(io_this->imageHeight - i_firstRow);
+  }
+  lead = microBmp_fillRange(io_this, i_firstRow, rows, &offset, &numBytes);
+  mem  = microBmp_blockRows(io_this, block, i_firstRow, rows);
+  io_this->cacheBlocks[block].rows = 0;           // invalid until the load has finished
+  io_this->pendingBlock    = block;
+  io_this->pendingFirstRow = i_firstRow;
+  io_this->loadPending     = 1;                   // before starting - the load may complete immediately
+  io_this->startLoadFunc(mem - lead, numBytes, offset, io_this->loadDataUserData);
+}
+
+/** registers the block of a finished asynchronous load, so it can be found by microBmp_selectCachedBlock */
+static void microBmp_finishLoad(microBmp_State* io_this)
+{
+  microBmp_CacheBlock* b;
+  if ((io_this->pendingBlock == MBMP_NO_BLOCK) || io_this->loadPending) {
+    return;
+  }
+  b = &io_this->cacheBlocks[io_this->pendingBlock];
+  b->firstRow = io_this->pendingFirstRow;
+  b->rows     = io_this->cacheSizeRows;
+  if (b->rows > io_this->imageHeight - b->firstRow) {
+    b->rows = (uint16_t)(io_this->imageHeight - b->firstRow);
+  }
+  io_this->pendingBlock = MBMP_NO_BLOCK;
+}
+
+/** starts loading the rows behind (or above if i_upwards) the current block in asynchronous mode, if they are not cached or loading yet */
+static void microBmp_prefetch(microBmp_State* io_this, int i_upwards)
+{
+  uint16_t next = (uint16_t)(io_this->blockFirstRow + io_this->blockRows);
+  uint16_t first = next;
+  if (i_upwards) {                                // the block above, next is its last row
+    next  = (uint16_t)(io_this->blockFirstRow - 1);
+    first = (io_this->blockFirstRow > io_this->cacheSizeRows) ? (uint16_t)(io_this->blockFirstRow - io_this->cacheSizeRows) : 0;
+  }
+  if (    io_this->startLoadFunc && (io_this->pendingBlock == MBMP_NO_BLOCK)
+       && (io_this->cachedRowBytes == io_this->bytesPerRow)
+       && (next < io_this->imageHeight)
+       && (microBmp_findCachedBlock(io_this, next) == MBMP_NO_BLOCK)) {
+    microBmp_startLoad(io_this, first);
+  }
+}
+
+/** announces the rows the walk continues with after the current block to the prefetchFunc, unless they are cached already */
+static void microBmp_announceNextBlock(microBmp_State* io_this, int i_upwards)
+{
+  uint16_t first, end;
+  if (!io_this->prefetchFunc || io_this->startLoadFunc) {
+    return;
+  }
+  if (i_upwards) {
+    end   = io_this->blockFirstRow;
+    first = (end > io_this->cacheSizeRows) ? (uint16_t)(end - io_this->cacheSizeRows) : 0;
+    if ((end == 0) || (microBmp_findCachedBlock(io_this, (uint16_t)(end - 1)) != MBMP_NO_BLOCK)) {
+      return;
+    }
+  } else {
+    first = (uint16_t)(io_this->blockFirstRow + io_this->blockRows);
+    end   = (io_this->prefetchEndRow - first > io_this->cacheSizeRows) ? (uint16_t)(first + io_this->cacheSizeRows) : io_this->prefetchEndRow;
+    if ((first >= io_this->prefetchEndRow) || (microBmp_findCachedBlock(io_this, first) != MBMP_NO_BLOCK)) {
+      return;
+    }
+  }
+  io_this->prefetchFunc(microBmp_rowsOffset(io_this, first, (uint16_t)(end - first)), io_this->bytesPerRow * (uint32_t)(end - first),
+                        io_this->loadDataUserData);
+}
+
+/**
+ * makes the rows from i_row to the end of the image (or from the first row to i_row if i_upwards)
+ * the current block if the source can map them, returns 0 if not
+ */
+static int microBmp_mapRows(microBmp_State* io_this, uint16_t i_row, int i_upwards)
+{
+  uint16_t       first = i_upwards ? 0 : i_row;
+  uint16_t       end   = i_upwards ? (uint16_t)(i_row + 1) : io_this->imageHeight;
+  const uint8_t* mapped;
+  if (!io_this->mapDataFunc) {
+    return 0;
+  }
+  mapped = (const uint8_t*)io_this->mapDataFunc(microBmp_rowsOffset(io_this, first, (uint16_t)(end - first)),
+                                                io_this->bytesPerRow * (uint32_t)(end - first), io_this->loadDataUserData);
+  if (!mapped) {
+    return 0;
+  }
+  io_this->blockFirstRow = first;
+  io_this->blockRows     = (uint16_t)(end - first);
+  io_this->blockData     = io_this->topDown ? mapped : mapped + io_this->bytesPerRow * (uint32_t)(end - first - 1);
+  io_this->rowStride     = microBmp_fileOrderStride(io_this, io_this->bytesPerRow);
+  return 1;
+}
+
+/**
+ * makes i_row the current row, loads a new block if the row is not cached
+ * \param[in] i_upwards  fill a new block with the rows above i_row instead of the rows below it
+ */
+static const uint8_t* microBmp_fetchRow(microBmp_State* io_this, uint16_t i_row, int i_upwards)
+{
+  uint16_t blockRow = (uint16_t)(i_row - io_this->blockFirstRow);
+  uint8_t  miss     = io_this->rowNotReady;     // the retries of a row that was not ready are counted once, as miss
+  microBmp_finishLoad(io_this);
+  if ((i_row < io_this->blockFirstRow) || (blockRow >= io_this->blockRows)) {
+    if (!microBmp_selectCachedBlock(io_this, i_row)) {
+      if (!microBmp_mapRows(io_this, i_row, i_upwards)) {
+        uint16_t first = i_row;
+        if (i_upwards) {
+          first = (i_row >= io_this->cacheSizeRows) ? (uint16_t)(i_row - io_this->cacheSizeRows + 1) : 0;
+        }
+        if (io_this->startLoadFunc && (io_this->cachedRowBytes == io_this->bytesPerRow)) {
+          if (io_this->pendingBlock == MBMP_NO_BLOCK) { // otherwise wait for the running load to finish first
+            microBmp_startLoad(io_this, first);
+          }
+          io_this->rowNotReady = 1;
+          return NULL;
+        }
+        microBmp_loadBlock(io_this, first);
+      }
+      miss = 1;
+    }
+    microBmp_announceNextBlock(io_this, i_upwards);
+  }
+  if (miss) {
+    ++io_this->cacheMisses;
+  } else {
+    ++io_this->cacheHits;
+  }
+  blockRow = (uint16_t)(i_row - io_this->blockFirstRow);
+  io_this->rowData     = io_this->blockData + (int32_t)blockRow * io_this->rowStride;
+  io_this->cachedRows  = (uint16_t)(io_this->blockRows - blockRow - 1);
+  io_this->currentRow  = (uint16_t)(i_row + 1);
+  io_this->rowY        = i_row;
+  io_this->rowNotReady = 0;
+  microBmp_prefetch(io_this, i_upwards);
+  return io_this->rowData;
+}
+
+/**
+ * fetchRow for the row getters - when walking upwards (file order) currentRow is the row returned last
+ * and cachedRows counts the rows above it in the block
+ */
+static const uint8_t* microBmp_fetchCurrentRow(microBmp_State* io_this, uint16_t i_row, int i_upwards)
+{
+  if (!microBmp_fetchRow(io_this, i_row, i_upwards)) {
+    return NULL;
+  }
+  if (microBmp_walksUp(io_this)) {
+    io_this->cachedRows = (uint16_t)(i_row - io_this->blockFirstRow);
+    io_this->currentRow = i_row;
+  }
+  return io_this->rowData;
+}
+
+const uint8_t* microBmp_getNextRow(microBmp_State * io_this) 
+{
+  if (microBmp_walksUp(io_this)) {               // the rows above the current row are still to go
+    if (io_this->currentRow == 0) {
+      return NULL;
+    }
+    return microBmp_fetchCurrentRow(io_this, (uint16_t)(io_this->currentRow - 1), 1);
+  }
+  if (io_this->currentRow >= io_this->imageHeight) {
+    return NULL;
+  }
+  return microBmp_fetchRow(io_this, io_this->currentRow, 0);
+}
+
+const uint8_t* microBmp_getRow(microBmp_State* io_this, uint16_t i_row)
+{
+  if (i_row >= io_this->imageHeight) {
+    return NULL;
+  }
+  return microBmp_fetchCurrentRow(io_this, i_row, microBmp_walksUp(io_this));
+}
+
+const uint8_t* microBmp_getPrevRow(microBmp_State* io_this)
+{
+  if (microBmp_walksUp(io_this)) {               // back to the row below, getNextRow continues upwards from it
+    if ((uint32_t)io_this->currentRow + 1 >= io_this->imageHeight) {
+      return NULL;
+    }
+    return microBmp_fetchCurrentRow(io_this, (uint16_t)(io_this->currentRow + 1), 0);
+  }
+  if (io_this->currentRow < 2) {
+    return NULL;
   }
+  return microBmp_fetchRow(io_this, (uint16_t)(io_this->currentRow - 2), 1);
+}
+
+const uint8_t* microBmp_getNextRows(microBmp_State* io_this, uint16_t i_maxRows, uint16_t* o_rowsAvailable)
+{
+  const uint8_t* first = NULL;
+  uint16_t       more  = 0;
+  if (i_maxRows > 0) {
+    first = microBmp_getNextRow(io_this);
+  }
+  if (first) {
+    more = io_this->cachedRows;
+    if (more > i_maxRows - 1) {
+      more = (uint16_t)(i_maxRows - 1);
+    }
+    io_this->cachedRows -= more;
+    if (microBmp_walksUp(io_this)) {
+      io_this->rowData    -= (int32_t)more * io_this->rowStride;
+      io_this->currentRow -= more;
+      io_this->rowY       -= more;
+    } else {
+      io_this->rowData    += (int32_t)more * io_this->rowStride;
+      io_this->currentRow += more;
+      io_this->rowY       += more;
+    }
+    ++more;
+  }
+  *o_rowsAvailable = more;
+  return first;
+}
+
+void microBmp_setNextRow(microBmp_State* io_this, uint16_t row)
+{
+  io_this->currentRow = microBmp_walksUp(io_this) ? (uint16_t)(row + 1) : row;
+}
+
+
+void microBmp_convertRowToRGB(const microBmp_State* i_this, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2) {
+  i_this->convertToRGB(i_this, i_this->rowData, o_targetBuf, x1, x2);
 }
 
 
 void microBmp_convertRowTo565(const microBmp_State* i_this, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2) {
-  /// \todo make efficient by dedicated implemtentation instead of converting to rgb and then back to 565
-  while (x1 < x2) {
-    bmp_RGB c = microBmp_getColorAt(i_this, x1);
-    *o_targetBuf =  ( ((uint16_t)c.r & 0xF8) << 8) 
-                  | ( ((uint16_t)c.g & 0xFC) << 3)
-                  | ( (uint16_t)c.b  >> 3 )
-      ;
-    o_targetBuf++;
-    ++x1;
+  i_this->convertTo565(i_this, i_this->rowData, o_targetBuf, x1, x2);
+}
+
+
+void microBmp_convertRowsToRGB(const microBmp_State* i_this, uint8_t* o_targetBuf, size_t i_targetStride, uint16_t x1, uint16_t x2, uint16_t i_numRows)
+{
+  const uint8_t* row = i_this->rowData;   // walk the run from its top row on
+  if (i_numRows == 0) {
+    return;
+  }
+  if (!microBmp_walksUp(i_this)) {
+    row -= (int32_t)(i_numRows - 1) * i_this->rowStride;
+  }
+  for (; i_numRows > 0; --i_numRows) {
+    i_this->convertToRGB(i_this, row, o_targetBuf, x1, x2);
+    o_targetBuf += i_targetStride;
+    row += i_this->rowStride;
   }
 }
 
 
+void microBmp_convertRowsTo565(const microBmp_State* i_this, uint16_t* o_targetBuf, size_t i_targetStride, uint16_t x1, uint16_t x2, uint16_t i_numRows)
+{
+  const uint8_t* row = i_this->rowData;   // walk the run from its top row on
+  if (i_numRows == 0) {
+    return;
+  }
+  if (!microBmp_walksUp(i_this)) {
+    row -= (int32_t)(i_numRows - 1) * i_this->rowStride;
+  }
+  for (; i_numRows > 0; --i_numRows) {
+    i_this->convertTo565(i_this, row, o_targetBuf, x1, x2);
+    o_targetBuf = (uint16_t*)((uint8_t*)o_targetBuf + i_targetStride);
+    row += i_this->rowStride;
+  }
+}
+
+
+microBmpStatus microBmp_blit(microBmp_State* io_this, void* o_fb, size_t i_fbStride, uint8_t i_fbFormat,
+                             int16_t i_dstX, int16_t i_dstY, const microBmp_Rect* i_clip)
+{
+  /* visible part of the image in framebuffer coordinates */
+  int32_t x1 = i_dstX;
+  int32_t y1 = i_dstY;
+  int32_t x2 = x1 + io_this->imageWidth;
+  int32_t y2 = y1 + io_this->imageHeight;
+  size_t  bytesPerPixel = (i_fbFormat == MBMP_TARGET_RGB565) ? sizeof(uint16_t) : 3;
+  uint16_t done;
+  if (i_clip) {
+    if (x1 < i_clip->x1) { x1 = i_clip->x1; }
+    if (y1 < i_clip->y1) { y1 = i_clip->y1; }
+    if (x2 > i_clip->x2) { x2 = i_clip->x2; }
+    if (y2 > i_clip->y2) { y2 = i_clip->y2; }
+  }
+  if (x1 < 0) { x1 = 0; }   // never write in front of the framebuffer
+  if (y1 < 0) { y1 = 0; }
+  if ((x1 >= x2) || (y1 >= y2)) {
+    io_this->blitRowsDone = 0;
+    return MBMP_STATUS_OK;
+  }
+
+  done = (io_this->blitRowsDone < y2 - y1) ? io_this->blitRowsDone : 0;   // continue behind the rows of an unfinished call
+  if (microBmp_walksUp(io_this)) {                // file order - from the bottom row of the visible part upwards
+    y2 -= done;
+    microBmp_setNextRow(io_this, (uint16_t)(y2 - 1 - i_dstY));
+  } else {
+    y1 += done;
+    microBmp_setNextRow(io_this, (uint16_t)(y1 - i_dstY));
+    microBmp_setPrefetchEnd(io_this, (uint16_t)(y2 - i_dstY));
+  }
+  while (y1 < y2) {
+    uint16_t rows;
+    int32_t  top;
+    uint8_t* target;
+    if (!microBmp_getNextRows(io_this, (uint16_t)(y2 - y1), &rows)) {
+      if (!io_this->rowNotReady) {
+        break;
+      }
+      if (io_this->loadPending) {                 // asynchronous load in progress (a completed one is used right away)
+        if (!io_this->waitLoadFunc) {
+          io_this->blitRowsDone = done;
+          microBmp_setPrefetchEnd(io_this, io_this->imageHeight);
+          return MBMP_STATUS_ROW_NOT_READY;
+        }
+        io_this->waitLoadFunc(io_this->loadDataUserData);
+      }
+      continue;
+    }
+    if (microBmp_walksUp(io_this)) {
+      y2 -= rows;
+      top = y2;
+    } else {
+      top = y1;
+      y1 += rows;
+    }
+    target = (uint8_t*)o_fb + (size_t)top * i_fbStride + (size_t)x1 * bytesPerPixel;
+    if (i_fbFormat == MBMP_TARGET_RGB565) {
+      microBmp_convertRowsTo565(io_this, (uint16_t*)target, i_fbStride, (uint16_t)(x1 - i_dstX), (uint16_t)(x2 - i_dstX), rows);
+    } else {
+      microBmp_convertRowsToRGB(io_this, target, i_fbStride, (uint16_t)(x1 - i_dstX), (uint16_t)(x2 - i_dstX), rows);
+    }
+    done = (uint16_t)(done + rows);
+  }
+  io_this->blitRowsDone = 0;
+  microBmp_setPrefetchEnd(io_this, io_this->imageHeight);
+  return MBMP_STATUS_OK;
+}
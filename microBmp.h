@@ -27,14 +27,66 @@ extern "C" {
  */
 typedef void (*microBmp_loadDataFunc)(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData);
 
+/**
+ *  optional user provided function that loads a rectangular region: i_numRows chunks of i_rowBytes bytes each.
+ *  Chunk n is read from "file" offset i_offset + n * i_srcStride and written to o_buffer + n * i_dstStride.
+ *  Allows serving a whole cache fill with a column window as one request (e.g. 2D DMA, preadv)
+ *  instead of one loadDataFunc call per row.
+ *
+ *  \param[in,out] io_userData   pointer to user data that was passed to init
+ */
+typedef void (*microBmp_loadStridedFunc)(void* o_buffer, uint32_t i_rowBytes, uint16_t i_numRows, uint32_t i_offset,
+                                         uint32_t i_srcStride, uint32_t i_dstStride, void* io_userData);
+
+/**
+ *  optional user provided function that returns a pointer to i_numBytes bytes of the "file" starting at i_offset
+ *  if the source is memory mapped (e.g. XIP flash or a mmap'ed file), so rows can be used without copying them.
+ *  The memory has to stay valid until the next call or until the image is not used anymore.
+ *
+ *  \returns pointer to the data or NULL if the range is not mapped - it is copied via the loadDataFunc then
+ */
+typedef const void* (*microBmp_mapDataFunc)(uint32_t i_offset, uint32_t i_numBytes, void* io_userData);
+
+/**
+ *  optional user provided function that starts loading the given amount of bytes from the offset into the given buffer
+ *  (e.g. by a DMA transfer) and returns immediately. microBmp_loadComplete has to be called when the data has arrived.
+ *  Same parameters as microBmp_loadDataFunc.
+ */
+typedef void (*microBmp_startLoadFunc)(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData);
+
+/**
+ *  optional user provided function that is called by microBmp_blit while the rows it needs are still being loaded
+ *  asynchronously. It should block until microBmp_loadComplete was called or at least for a while
+ *  (e.g. wait for the DMA interrupt, a semaphore or the completion queue), microBmp_blit checks the load again afterwards.
+ */
+typedef void (*microBmp_waitLoadFunc)(void* io_userData);
+
+/**
+ *  optional user provided function that is told which bytes of the "file" the decoder will load next
+ *  (the block behind the one that just became current). It is only a hint - the data is still requested via the
+ *  loadDataFunc, but the source can start reading it in the meantime (e.g. SD card or flash reads, madvise(WILLNEED)).
+ */
+typedef void (*microBmp_prefetchFunc)(uint32_t i_offset, uint32_t i_numBytes, void* io_userData);
+
 typedef enum {
   MBMP_STATUS_OK=0, 
   MBMP_STATUS_CACHE_BUFFER_TOO_SMALL, 
   MBMP_STATUS_UNSUPPORTED_FILE_TYPE,
-  MBMP_STATUS_UNSUPPORTED_BMP_FORMAT
+  MBMP_STATUS_UNSUPPORTED_BMP_FORMAT,
+  MBMP_STATUS_ROW_NOT_READY          /**< microBmp_blit - a row is still being loaded asynchronously and no microBmp_waitLoadFunc is set */
 } microBmpStatus; 
 
 
+/** options for microBmp_initEx */
+typedef enum {
+  MBMP_INIT_DEFAULT         = 0,
+  MBMP_INIT_PALETTE_LUT_RGB = 1 << 0,  /**< expand the palette of indexed images once into a packed RGB table to speed up microBmp_convertRowToRGB */
+  MBMP_INIT_PALETTE_LUT_565 = 1 << 1,  /**< expand the palette of indexed images once into a RGB565 table to speed up microBmp_convertRowTo565 */
+  MBMP_INIT_NO_SIMD         = 1 << 2,  /**< only use the portable scalar row converters (e.g. as reference to cross check the SIMD ones) */
+  MBMP_INIT_FILE_ORDER      = 1 << 3   /**< microBmp_getNextRow(s) returns the rows in the order they are stored in the file, see rowY */
+} microBmpInitFlags;
+
+
 #ifdef _MSC_VER
 #  define BMP_STRUCTPACK_ATT 
 #  pragma pack(push,1)
@@ -77,7 +129,89 @@ typedef struct BMP_STRUCTPACK_ATT {
 #endif
 
 
+struct microBmp_State;
+
+/**
+ * row converter that writes the pixels [x1, x2[ of the source row i_row as RGB tuples into o_targetBuf
+ * one specialized implementation per source format is selected by microBmp_init, i_this only supplies the format
+ */
+typedef void (*microBmp_convertToRGBFunc)(const struct microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2);
+
+/**
+ * row converter that writes the pixels [x1, x2[ of the source row i_row as RGB565 values into o_targetBuf
+ * one specialized implementation per source format is selected by microBmp_init, i_this only supplies the format
+ */
+typedef void (*microBmp_convertTo565Func)(const struct microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2);
+
+/**
+ * user provided function that receives the rows in push mode (see microBmp_initFeed) in the order they are stored in the file.
+ * i_this->rowData is i_row during the call, so the microBmp_convertRow* functions can be used on i_this.
+ *
+ *  \param[in]     i_row         raw data of the row, only valid until the function returns
+ *  \param[in]     i_y           image row (0 - top)
+ *  \param[in,out] io_userData   pointer to user data that was passed to microBmp_initFeed
+ */
+typedef void (*microBmp_rowFunc)(const struct microBmp_State* i_this, const uint8_t* i_row, uint16_t i_y, void* io_userData);
+
+/** progress of the push mode (microBmp_State::feedPhase) */
+typedef enum {
+  MBMP_FEED_HEADER = 0,      /**< collecting the headers and the palette */
+  MBMP_FEED_ROWS,            /**< passing the rows to the rowFunc */
+  MBMP_FEED_DONE,            /**< all rows are passed on, further bytes are ignored */
+  MBMP_FEED_FAILED           /**< the headers are not supported, microBmp_feed returns the reason */
+} microBmp_FeedPhase;
+
+/** pixel formats of a target framebuffer for microBmp_blit */
+typedef enum {
+  MBMP_TARGET_RGB888 = 0,    /**< 3 bytes per pixel in order r, g, b */
+  MBMP_TARGET_RGB565         /**< native endian uint16_t per pixel */
+} microBmp_TargetFormat;
+
+/** rectangle [x1, x2[ x [y1, y2[ */
 typedef struct {
+  int16_t x1;
+  int16_t y1;
+  int16_t x2;
+  int16_t y2;
+} microBmp_Rect;
+
+/** value of microBmp_State::pendingBlock if no asynchronous load is started */
+#define MBMP_NO_BLOCK 0xFF
+
+/** descriptor of one cache block if the cache is split into several blocks (see microBmp_setupCache) */
+typedef struct {
+  uint16_t firstRow;         /**< first image row held by the block */
+  uint16_t rows;             /**< number of valid image rows in the block (0 - empty) */
+  uint32_t stamp;            /**< data of the cache policy (e.g. time of last use or reference bit) */
+} microBmp_CacheBlock;
+
+/** replacement policy of a cache that is split into several blocks */
+typedef struct microBmp_CachePolicy {
+  /** called whenever block i_block is used after another block was used or after it was loaded */
+  void    (*touch) (struct microBmp_State* io_this, uint8_t i_block);
+  /** returns the index of the block that gets replaced by the next load */
+  uint8_t (*victim)(struct microBmp_State* io_this);
+} microBmp_CachePolicy;
+
+/** replaces the least recently used block */
+extern const microBmp_CachePolicy microBmp_cachePolicyLRU;
+/** second chance (clock) replacement - cheaper than LRU but only approximates it */
+extern const microBmp_CachePolicy microBmp_cachePolicyClock;
+
+/** source pixel formats that have dedicated row converters */
+typedef enum {
+  MBMP_PIXFMT_INDEX1 = 0,    /**< 1bit palette index */
+  MBMP_PIXFMT_INDEX4,        /**< 4bit palette index */
+  MBMP_PIXFMT_INDEX8,        /**< 8bit palette index */
+  MBMP_PIXFMT_BITFIELD16,    /**< 16bit with arbitrary color masks */
+  MBMP_PIXFMT_RGB565,        /**< 16bit with standard 565 color masks */
+  MBMP_PIXFMT_RGB555,        /**< 16bit with standard 555 color masks */
+  MBMP_PIXFMT_BGR24,         /**< 24bit BGR */
+  MBMP_PIXFMT_BGRX32,        /**< 32bit BGR with unused 4th byte */
+  MBMP_PIXFMT_COUNT
+} microBmp_PixelFormat;
+
+typedef struct microBmp_State {
   uint16_t imageWidth;
   uint16_t imageHeight;
   uint32_t bytesPerRow;      /**< Size of a row in bytes */
@@ -90,21 +224,67 @@ typedef struct {
   uint8_t  maskR;            /**< bit mask of r color after shifting if 16bit image */
   uint8_t  maskG;            /**< bit mask of g color after shifting if 16bit image */
   uint8_t  maskB;            /**< bit mask of b color after shifting if 16bit image */
+  uint8_t  expMulR;          /**< multiplier that replicates the r bits to fill 8bit if 16bit image */
+  uint8_t  expMulG;          /**< multiplier that replicates the g bits to fill 8bit if 16bit image */
+  uint8_t  expMulB;          /**< multiplier that replicates the b bits to fill 8bit if 16bit image */
+  uint8_t  expShiftR;        /**< right shift applied after expMulR */
+  uint8_t  expShiftG;        /**< right shift applied after expMulG */
+  uint8_t  expShiftB;        /**< right shift applied after expMulB */
+  uint8_t  pixelFormat;      /**< one of microBmp_PixelFormat */
+  uint8_t  topDown;          /**< rows are stored top down (negative height), otherwise bottom up (bmp's default case) */
+  uint8_t  fileOrder;        /**< MBMP_INIT_FILE_ORDER - bottom up images are read from their last row upwards */
 
   uint32_t endOfImage;       /**< End of the image data in the "file" */
-  uint16_t currentRow;       /**< Current row, starting at 0 */
-
-
-
-  uint16_t cachedRows;       /**< Number of rows currently cached */
-  uint16_t cacheSizeRows;    /**< Cache Size in rows */
-  uint32_t cacheSizeBytes;   /**< Cache Size in bytes */
+  uint16_t currentRow;       /**< Current row, starting at 0 (with MBMP_INIT_FILE_ORDER for bottom up images: number of rows still to go) */
+  uint16_t rowY;             /**< image row (0 - top) of the row returned last */
+
+
+
+  uint16_t cachedRows;       /**< Number of rows behind the current row that are already in memory */
+  uint16_t cacheSizeRows;    /**< Cache Size in rows (per block, if the cache is split into several blocks) */
+  uint16_t blockFirstRow;    /**< first image row held by the cache block */
+  uint16_t blockRows;        /**< number of valid image rows in the cache block (0 if nothing is loaded yet) */
+  uint32_t cacheSizeBytes;   /**< Cache Size in bytes (per block, if the cache is split into several blocks) */
+  uint32_t cacheBufferSize;  /**< bytes of the provided buffer that are available for cached rows */
+  uint32_t cachedRowBytes;   /**< bytes of a cached row (less than bytesPerRow if a column window is set) */
+  uint32_t windowByteOffset; /**< offset of the first cached byte within a row if a column window is set */
+  uint32_t loadAlignment;    /**< cache fills with complete rows start and end at multiples of it (see microBmp_setLoadAlignment) */
+  const uint8_t * blockData; /**< data of row blockFirstRow in the cache block, the following rows are rowStride apart */
+
+  microBmp_CacheBlock*        cacheBlocks;      /**< descriptors of all cache blocks (NULL - a single block) */
+  const microBmp_CachePolicy* cachePolicy;      /**< replacement policy if the cache is split into several blocks */
+  uint32_t                    cachePolicyData;  /**< state of the cache policy (e.g. LRU time or clock hand) */
+  uint8_t                     numCacheBlocks;   /**< number of cache blocks */
+  uint8_t                     pendingBlock;     /**< cache block an asynchronous load is started for (MBMP_NO_BLOCK - none) */
+  uint16_t                    pendingFirstRow;  /**< first image row of pendingBlock */
+  volatile uint8_t            loadPending;      /**< set while the asynchronous load of pendingBlock is in progress */
+  uint8_t                     rowNotReady;      /**< set if the last row request returned NULL since the row is still being loaded */
+  uint32_t                    cacheHits;        /**< number of fetched rows that were already in memory */
+  uint32_t                    cacheMisses;      /**< number of fetched rows that required loading a block (or waiting for one) */
+  uint16_t                    prefetchEndRow;   /**< rows from here on are not announced to the prefetchFunc (end of a crop) */
+  uint16_t                    blitRowsDone;     /**< visible rows drawn by a microBmp_blit that returned MBMP_STATUS_ROW_NOT_READY */
+  microBmp_rowFunc            rowFunc;          /**< push mode - receives the rows (see microBmp_initFeed) */
+  uint32_t                    feedFlags;        /**< push mode - flags passed on to microBmp_initEx once the headers are complete */
+  uint32_t                    feedFill;         /**< push mode - bytes of the headers or of the partial row collected so far */
+  uint8_t                     feedPhase;        /**< push mode - one of microBmp_FeedPhase */
+  uint8_t                     feedStatus;       /**< push mode - reason of MBMP_FEED_FAILED */
 
   const uint8_t * rowData;         /**< Current row data */
+  int32_t  rowStride;        /**< address difference from one row to the next in memory (negative if the rows are stored bottom up) */
   uint8_t * imageData;       /**< Loaded image data */
   uint8_t * palette;
+  uint16_t* paletteLut565;   /**< palette expanded to RGB565 (NULL if not requested) */
+  uint8_t * paletteLutRGB;   /**< palette expanded to packed RGB tuples (NULL if not requested) */
+  uint8_t * paletteSimd;     /**< palette of 1/4bit images prepared for the SIMD converters (NULL if they do not use one) */
   microBmp_loadDataFunc loadDataFunc;
+  microBmp_loadStridedFunc loadStridedFunc;  /**< optional, loads all rows of a column window at once */
+  microBmp_mapDataFunc  mapDataFunc;         /**< optional, provides rows of memory mapped sources without copying */
+  microBmp_startLoadFunc startLoadFunc;      /**< optional, starts asynchronous loads of cache blocks */
+  microBmp_waitLoadFunc waitLoadFunc;        /**< optional, lets microBmp_blit wait for asynchronous loads */
+  microBmp_prefetchFunc prefetchFunc;        /**< optional, hint about the block that is loaded next */
   void*                 loadDataUserData;
+  microBmp_convertToRGBFunc convertToRGB;  /**< row converter for the source format, selected at init */
+  microBmp_convertTo565Func convertTo565;  /**< row converter for the source format, selected at init */
 } microBmp_State;
 
 /**
@@ -121,6 +301,137 @@ typedef struct {
  */
 microBmpStatus microBmp_init(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_loadDataFunc i_loadDataFunc, void* i_userData);
 
+/**
+ * same as microBmp_init but with additional options
+ *
+ * @param[in]  i_flags              combination of microBmpInitFlags
+ *                                  The palette lookup tables are placed in io_buffer behind the palette, 
+ *                                  so they reduce the space for cached rows (2 or 3 bytes per palette entry).
+ *                                  They are only created if i_loadDataFunc is non-NULL, since otherwise io_buffer is read only.
+ */
+microBmpStatus microBmp_initEx(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_loadDataFunc i_loadDataFunc, void* i_userData, uint32_t i_flags);
+
+/**
+ * same as microBmp_initEx but opens the image with a single (speculative) loadDataFunc call of the first i_prefixBytes
+ * bytes of the file instead of one call each for headers, palette and the first cache block.
+ * Headers and palette are taken from the prefix, complete rows within it are kept as cache block, so a small image whose
+ * data is part of the prefix needs no further load. Parts of headers or palette behind the prefix are loaded as usual.
+ * microBmp_setupCache, microBmp_setColumnWindow and microBmp_setAsyncLoad discard the kept rows.
+ *
+ * @param[in]  i_prefixBytes        bytes read at once, e.g. the typical file size of small images or the size of a
+ *                                  flash page or SD sector (limited to i_buffersize)
+ */
+microBmpStatus microBmp_initPrefix(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, uint32_t i_prefixBytes,
+                                   microBmp_loadDataFunc i_loadDataFunc, void* i_userData, uint32_t i_flags);
+
+/**
+ * prepares decoding in push mode, for sources that can not seek (pipes, sockets, serial transfers, decompressors):
+ * the file is passed on piecewise with microBmp_feed from its first byte on and every complete row is handed to
+ * i_rowFunc in file order (bottom up images from their last row upwards).
+ * io_buffer has to hold the headers including the palette (imageDataOffset bytes of the file) at first,
+ * afterwards it holds the palette (and lookup tables, see i_flags) and at most one partial row.
+ * The state must only be used from the rowFunc (microBmp_convertRow*) - the pull functions
+ * (microBmp_getNextRow, microBmp_blit, ...) do not work in push mode.
+ *
+ * @param[in]  i_rowFunc   receives the rows
+ * @param[in]  i_userData  optional pointer to user specific data that is passed on to i_rowFunc
+ * @param[in]  i_flags     combination of microBmpInitFlags (MBMP_INIT_FILE_ORDER is implied)
+ */
+microBmpStatus microBmp_initFeed(microBmp_State* o_this, uint8_t* io_buffer, size_t i_buffersize, microBmp_rowFunc i_rowFunc, void* i_userData, uint32_t i_flags);
+
+/**
+ * passes the next i_numBytes bytes of the file on (push mode, see microBmp_initFeed). Complete rows are handed to the rowFunc
+ * before the function returns, rows that are complete within i_data are passed on in place without copying them.
+ * The image is complete when feedPhase is MBMP_FEED_DONE (currentRow counts the rows passed on).
+ *
+ * \returns MBMP_STATUS_OK or the reason why the image can not be decoded (also for all further calls)
+ */
+microBmpStatus microBmp_feed(microBmp_State* io_this, const uint8_t* i_data, size_t i_numBytes);
+
+/**
+ * splits the cache into i_numBlocks independently loaded blocks, that are replaced by i_policy.
+ * This speeds up access patterns that jump between some image regions (see microBmp_getRow).
+ * Has to be called once directly after init, discards the cached rows. The block descriptors are taken from the cache buffer.
+ * Does nothing if the whole image is in memory (no loadDataFunc).
+ *
+ * @param[in]  i_numBlocks  number of blocks (1..255)
+ * @param[in]  i_policy     replacement policy, NULL - microBmp_cachePolicyLRU
+ */
+microBmpStatus microBmp_setupCache(microBmp_State* io_this, uint8_t i_numBlocks, const microBmp_CachePolicy* i_policy);
+
+/**
+ * restricts loading to the bytes of each row that hold the pixels [i_x1, i_x2[ (column window / region of interest),
+ * so the cache holds correspondingly more rows. Pixels outside the window must not be converted afterwards.
+ * i_x1 >= i_x2 or the full image width switches back to loading complete rows.
+ * Discards the cached rows. Does nothing if the whole image is in memory (no loadDataFunc).
+ */
+microBmpStatus microBmp_setColumnWindow(microBmp_State* io_this, uint16_t i_x1, uint16_t i_x2);
+
+/**
+ * declares the natural block size of the source (e.g. 512 for SD card sectors, 4096 for flash pages or the O_DIRECT alignment),
+ * so cache fills are widened to start and end at multiples of it, except that a fill reaching the end of the image data
+ * ends exactly there. The cache blocks are placed at addresses that are multiples of it,
+ * so the fills are aligned in memory as well. This needs up to 3 * (i_blockSize - 1) bytes of the cache buffer per block.
+ * Without it (1) exactly the bytes of the rows are loaded. Does not apply to the rows of a column window.
+ * Discards the cached rows. Does nothing if the whole image is in memory (no loadDataFunc).
+ */
+microBmpStatus microBmp_setLoadAlignment(microBmp_State* io_this, uint32_t i_blockSize);
+
+/**
+ * sets a function that loads the rows of a column window (see microBmp_setColumnWindow) with a single request.
+ * It gets the same user data as the loadDataFunc. NULL - load each row with its own loadDataFunc call.
+ */
+static inline void microBmp_setLoadStridedFunc(microBmp_State* io_this, microBmp_loadStridedFunc i_loadStridedFunc) {
+  io_this->loadStridedFunc = i_loadStridedFunc;
+}
+
+/**
+ * sets a function that maps rows of memory mapped sources, so they are used in place instead of copying them into the cache.
+ * It gets the same user data as the loadDataFunc, that is still used for the headers and if mapping fails.
+ * NULL - always copy.
+ */
+static inline void microBmp_setMapDataFunc(microBmp_State* io_this, microBmp_mapDataFunc i_mapDataFunc) {
+  io_this->mapDataFunc = i_mapDataFunc;
+}
+
+/**
+ * sets a function that is told about the block that will be loaded next whenever the decoder moves on to another block.
+ * It gets the same user data as the loadDataFunc. Not called in asynchronous mode (the next block is loaded already then).
+ * NULL - no hints.
+ */
+static inline void microBmp_setPrefetchFunc(microBmp_State* io_this, microBmp_prefetchFunc i_prefetchFunc) {
+  io_this->prefetchFunc = i_prefetchFunc;
+}
+
+/**
+ * rows from i_endRow on are not needed (e.g. the end of a crop), so they are not announced to the prefetchFunc.
+ * microBmp_blit sets it for the rows it draws.
+ */
+static inline void microBmp_setPrefetchEnd(microBmp_State* io_this, uint16_t i_endRow) {
+  io_this->prefetchEndRow = (i_endRow < io_this->imageHeight) ? i_endRow : io_this->imageHeight;
+}
+
+/**
+ * switches to asynchronous loading of the image rows: the cache is split into two blocks (instead of microBmp_setupCache),
+ * while the rows of one block are read, the following block is loaded into the other one via i_startLoadFunc.
+ * If a requested row is not loaded yet, the row functions return NULL and set rowNotReady instead of waiting.
+ * Headers, palette and rows of a column window are still loaded with the loadDataFunc.
+ * microBmp_blit waits for pending loads through the microBmp_waitLoadFunc (see microBmp_setWaitLoadFunc),
+ * so microBmp_loadComplete has to be called from an interrupt (or another thread) then.
+ * Has to be called once directly after init.
+ */
+microBmpStatus microBmp_setAsyncLoad(microBmp_State* io_this, microBmp_startLoadFunc i_startLoadFunc);
+
+/** sets the function microBmp_blit calls while a row it needs is still being loaded asynchronously */
+static inline void microBmp_setWaitLoadFunc(microBmp_State* io_this, microBmp_waitLoadFunc i_waitLoadFunc) {
+  io_this->waitLoadFunc = i_waitLoadFunc;
+}
+
+/** has to be called when the load started by the microBmp_startLoadFunc has finished (may be called from an interrupt) */
+static inline void microBmp_loadComplete(microBmp_State* io_this) {
+  io_this->loadPending = 0;
+}
+
 /**
  * deinitializes the object - should be called after object is not needed anymore
  * Currently does not do anything (and probably never will).
@@ -132,6 +443,7 @@ static inline void microBmp_deinit(microBmp_State* io_this) {
 
 /**
  * sets the row that is read with microBmp_getNextRow
+ * The cached rows are kept, so seeking within the cache block does not load anything.
  */
 void microBmp_setNextRow(microBmp_State* io_this, uint16_t row);
 
@@ -139,18 +451,85 @@ void microBmp_setNextRow(microBmp_State* io_this, uint16_t row);
 /**
  * returns pointer to the image data of the next row 
  * loads data if required via the loadDataFunc 
+ * In asynchronous mode NULL is also returned if the row is still being loaded (rowNotReady is set then) - just try again later.
+ * With MBMP_INIT_FILE_ORDER the rows of bottom up images are returned from the last row upwards, so the loads are
+ * forward reads through the file. rowY tells which image row was returned.
  * 
  * \returns pointer to raw image data. this can be an index to palette or BGR or BGRA tuples
  *          use one of the microBmp_convertRowTo* functions to get actual image data 
  */
 const uint8_t* microBmp_getNextRow(microBmp_State * io_this);
 
+/**
+ * returns pointer to the image data of row i_row (0 is the top row) and makes it the current row,
+ * so microBmp_getNextRow continues with the row after it (the row above it with MBMP_INIT_FILE_ORDER and bottom up images).
+ * loads data if required via the loadDataFunc.
+ *
+ * \returns pointer to raw image data or NULL if i_row is outside the image
+ */
+const uint8_t* microBmp_getRow(microBmp_State* io_this, uint16_t i_row);
+
+/**
+ * moves one row up and returns pointer to the image data of the row above the current row
+ * (the row above the one last returned by microBmp_getNextRow or microBmp_getPrevRow).
+ * loads data if required via the loadDataFunc. In that case the block is filled with the rows above the requested one,
+ * so walking further upwards is served from the cache.
+ * With MBMP_INIT_FILE_ORDER and bottom up images getNextRow walks upwards, so this steps back to the row below the
+ * current row (and fills the block with the rows below it).
+ *
+ * \returns pointer to raw image data or NULL if the current row is the first row of the walk (or no row was read yet)
+ */
+const uint8_t* microBmp_getPrevRow(microBmp_State* io_this);
+
+/**
+ * returns a run of up to i_maxRows rows starting with the next row, that are already in memory
+ * (loads data if required via the loadDataFunc, but never more than one cache block).
+ * The rows are i_this->rowStride bytes apart (they follow each other at decreasing addresses for bottom up bmps),
+ * with MBMP_INIT_FILE_ORDER the run of a bottom up bmp goes upwards (-rowStride).
+ * Afterwards the last row of the run is the current row.
+ *
+ * \param[out] o_rowsAvailable  number of rows in the run (0 if there are no more rows)
+ * \returns pointer to raw image data of the first row of the run or NULL if there are no more rows
+ */
+const uint8_t* microBmp_getNextRows(microBmp_State* io_this, uint16_t i_maxRows, uint16_t* o_rowsAvailable);
+
 /** returns the bitmap data of the current row from pixel [x1, x2[ into rgb and writes the data into o_targetbuf */
 void microBmp_convertRowToRGB(const microBmp_State* i_this, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2);
 
 /** returns the bitmap data of the current row from pixel [x1, x2[ into 16bit RGB565 and writes the data into o_targetbuf */
 void microBmp_convertRowTo565(const microBmp_State* i_this, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2);
 
+/**
+ * converts pixel [x1, x2[ of the last i_numRows rows returned by microBmp_getNextRows (i_numRows <= o_rowsAvailable) into rgb.
+ * Row n of the run counted from its top image row is written to o_targetBuf + n * i_targetStride (stride in bytes).
+ */
+void microBmp_convertRowsToRGB(const microBmp_State* i_this, uint8_t* o_targetBuf, size_t i_targetStride, uint16_t x1, uint16_t x2, uint16_t i_numRows);
+
+/**
+ * converts pixel [x1, x2[ of the last i_numRows rows returned by microBmp_getNextRows (i_numRows <= o_rowsAvailable) into 16bit RGB565.
+ * Row n of the run counted from its top image row is written to (uint8_t*)o_targetBuf + n * i_targetStride (stride in bytes).
+ */
+void microBmp_convertRowsTo565(const microBmp_State* i_this, uint16_t* o_targetBuf, size_t i_targetStride, uint16_t x1, uint16_t x2, uint16_t i_numRows);
+
+
+/**
+ * decodes the image directly into a framebuffer, so no intermediate row buffer is required.
+ * The top left image pixel is placed at (i_dstX, i_dstY) of the framebuffer. Only pixels inside i_clip are written,
+ * rows that are clipped away vertically are not loaded at all.
+ * Afterwards the current row is the last drawn row.
+ * In asynchronous mode the waitLoadFunc is called while a row is still being loaded. Without one the function
+ * returns MBMP_STATUS_ROW_NOT_READY instead. The call has to be repeated with the same parameters then
+ * (e.g. once the load has completed), it continues behind the rows that were already drawn.
+ *
+ * @param[out] o_fb        framebuffer, pixel (0,0) at its start
+ * @param[in]  i_fbStride  distance of two framebuffer lines in bytes
+ * @param[in]  i_fbFormat  one of microBmp_TargetFormat
+ * @param[in]  i_clip      framebuffer area that may be written (typically the framebuffer bounds),
+ *                         NULL - only pixels with negative framebuffer coordinates are clipped
+ * \returns MBMP_STATUS_OK or MBMP_STATUS_ROW_NOT_READY
+ */
+microBmpStatus microBmp_blit(microBmp_State* io_this, void* o_fb, size_t i_fbStride, uint8_t i_fbFormat,
+                             int16_t i_dstX, int16_t i_dstY, const microBmp_Rect* i_clip);
 
 
 #ifdef __cplusplus
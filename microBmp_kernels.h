@@ -0,0 +1,77 @@
+/**
+ * internal interface between microBmp.c and the optional platform specific row converters.
+ * Not meant to be included by users of the library.
+ */
+
+#ifndef BMP_IMAGE_KERNELS_HEADER
+#define BMP_IMAGE_KERNELS_HEADER
+
+#include "microBmp.h"
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#  define MBMP_BIG_ENDIAN
+#endif
+
+#if    !defined(MBMP_GENERIC_CONVERTERS) && !defined(MBMP_NO_SIMD) && !defined(MBMP_SWAR) \
+    && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#  define MBMP_SIMD_X86
+#endif
+
+#if    !defined(MBMP_GENERIC_CONVERTERS) && !defined(MBMP_NO_SIMD) \
+    && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#  define MBMP_SIMD_NEON
+#endif
+
+/* word-at-a-time converters for 32bit ARM cores without NEON, MBMP_SWAR forces them on any other target */
+#if    !defined(MBMP_GENERIC_CONVERTERS) && !defined(MBMP_NO_SIMD) && !defined(MBMP_SIMD_NEON) \
+    && (defined(MBMP_SWAR) || defined(__arm__))
+#  define MBMP_SIMD_SWAR
+#endif
+
+
+static inline uint16_t microBmp_rgbTo565(uint8_t r, uint8_t g, uint8_t b)
+{
+  return   ( ((uint16_t)r & 0xF8) << 8)
+         | ( ((uint16_t)g & 0xFC) << 3)
+         | ( (uint16_t)b  >> 3 );
+}
+
+/** reads a little endian 16bit value */
+static inline uint16_t microBmp_read16(const uint8_t* p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/** extracts one channel of a 16bit pixel and expands it to 8bit with the constants of microBmp_State (expMul*, expShift*) */
+static inline uint8_t microBmp_expand16(uint16_t c16, uint8_t shift, uint8_t mask, uint8_t mul, uint8_t expShift)
+{
+  return (uint8_t)((((c16 >> shift) & mask) * mul) >> expShift);
+}
+
+
+#ifdef MBMP_SIMD_X86
+/**
+ * replaces the already selected scalar converters of io_this->pixelFormat by
+ * SSE2/SSSE3/AVX2 implementations if the cpu supports them (checked at runtime)
+ */
+void microBmp_selectConvertersX86(microBmp_State* io_this);
+
+/**
+ * bytes (16 byte aligned) of the palette of 1 and 4 bit images split into byte planes for the SSSE3 converters,
+ * 0 if they are not used. microBmp_selectConvertersX86 fills io_this->paletteSimd once if it is provided.
+ */
+size_t microBmp_x86PaletteBytes(const microBmp_State* i_this);
+#endif
+
+#ifdef MBMP_SIMD_NEON
+/** replaces the already selected scalar converters of io_this->pixelFormat by NEON implementations */
+void microBmp_selectConvertersNeon(microBmp_State* io_this);
+#endif
+
+#ifdef MBMP_SIMD_SWAR
+/** replaces the already selected scalar converters of io_this->pixelFormat by 32bit word-at-a-time implementations */
+void microBmp_selectConvertersSwar(microBmp_State* io_this);
+#endif
+
+
+#endif
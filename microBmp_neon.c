@@ -0,0 +1,196 @@
+/**
+ * NEON row converters for ARMv7-A (built with -mfpu=neon) and AArch64 targets.
+ * NEON availability is decided at compile time.
+ * Only pixels that are part of [x1, x2[ are read, the remaining pixels are converted by a scalar tail.
+ */
+
+#include "microBmp_kernels.h"
+
+#ifdef MBMP_SIMD_NEON
+
+#include <arm_neon.h>
+
+
+/* scalar tails */
+
+static void microBmp_neonTailBgrToRGB(const uint8_t* src, uint8_t bytesPerPixel, uint8_t* o_targetBuf, uint16_t n)
+{
+  while (n--) {
+    o_targetBuf[0] = src[2];
+    o_targetBuf[1] = src[1];
+    o_targetBuf[2] = src[0];
+    o_targetBuf += 3;
+    src += bytesPerPixel;
+  }
+}
+
+static void microBmp_neonTailBgrTo565(const uint8_t* src, uint8_t bytesPerPixel, uint16_t* o_targetBuf, uint16_t n)
+{
+  while (n--) {
+    *o_targetBuf++ = microBmp_rgbTo565(src[2], src[1], src[0]);
+    src += bytesPerPixel;
+  }
+}
+
+
+/** packs 8 r, g and b values to RGB565 by shift-right-inserting g and b below r */
+static inline uint16x8_t microBmp_neonPack565(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+  uint16x8_t v = vshll_n_u8(r, 8);
+  v = vsriq_n_u16(v, vshll_n_u8(g, 8), 5);
+  v = vsriq_n_u16(v, vshll_n_u8(b, 8), 11);
+  return v;
+}
+
+
+static void microBmp_bgr24ToRGB_neon(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    uint8x16x3_t bgr = vld3q_u8(src);
+    uint8x16x3_t rgb;
+    rgb.val[0] = bgr.val[2];
+    rgb.val[1] = bgr.val[1];
+    rgb.val[2] = bgr.val[0];
+    vst3q_u8(o_targetBuf, rgb);
+    o_targetBuf += 48;
+    src += 48;
+  }
+  if (x1 < x2) {
+    microBmp_neonTailBgrToRGB(src, 3, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+static void microBmp_bgrx32ToRGB_neon(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    uint8x16x4_t bgrx = vld4q_u8(src);
+    uint8x16x3_t rgb;
+    rgb.val[0] = bgrx.val[2];
+    rgb.val[1] = bgrx.val[1];
+    rgb.val[2] = bgrx.val[0];
+    vst3q_u8(o_targetBuf, rgb);
+    o_targetBuf += 48;
+    src += 64;
+  }
+  if (x1 < x2) {
+    microBmp_neonTailBgrToRGB(src, 4, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+static void microBmp_bgr24To565_neon(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    uint8x16x3_t bgr = vld3q_u8(src);
+    vst1q_u16(o_targetBuf,     microBmp_neonPack565(vget_low_u8 (bgr.val[2]), vget_low_u8 (bgr.val[1]), vget_low_u8 (bgr.val[0])));
+    vst1q_u16(o_targetBuf + 8, microBmp_neonPack565(vget_high_u8(bgr.val[2]), vget_high_u8(bgr.val[1]), vget_high_u8(bgr.val[0])));
+    o_targetBuf += 16;
+    src += 48;
+  }
+  if (x1 < x2) {
+    microBmp_neonTailBgrTo565(src, 3, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+static void microBmp_bgrx32To565_neon(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    uint8x16x4_t bgrx = vld4q_u8(src);
+    vst1q_u16(o_targetBuf,     microBmp_neonPack565(vget_low_u8 (bgrx.val[2]), vget_low_u8 (bgrx.val[1]), vget_low_u8 (bgrx.val[0])));
+    vst1q_u16(o_targetBuf + 8, microBmp_neonPack565(vget_high_u8(bgrx.val[2]), vget_high_u8(bgrx.val[1]), vget_high_u8(bgrx.val[0])));
+    o_targetBuf += 16;
+    src += 64;
+  }
+  if (x1 < x2) {
+    microBmp_neonTailBgrTo565(src, 4, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+#ifndef MBMP_BIG_ENDIAN
+
+/** shift, mask and expansion constants of one 16bit channel, see microBmp_State::expMulR */
+typedef struct {
+  int16x8_t  shift;     /**< negative - vshl shifts right */
+  uint16x8_t mask;
+  uint16x8_t mul;
+  int16x8_t  expShift;  /**< negative - vshl shifts right */
+} microBmp_channel16_neon;
+
+static inline microBmp_channel16_neon microBmp_channel16Setup_neon(uint8_t shift, uint8_t mask, uint8_t mul, uint8_t expShift)
+{
+  microBmp_channel16_neon c;
+  c.shift    = vdupq_n_s16((int16_t)-shift);
+  c.mask     = vdupq_n_u16(mask);
+  c.mul      = vdupq_n_u16(mul);
+  c.expShift = vdupq_n_s16((int16_t)-expShift);
+  return c;
+}
+
+/** expands one 16bit channel of 8 pixels to 0..255 */
+static inline uint8x8_t microBmp_expand16x8_neon(uint16x8_t v, const microBmp_channel16_neon* c)
+{
+  v = vandq_u16(vshlq_u16(v, c->shift), c->mask);
+  v = vmulq_u16(v, c->mul);
+  return vmovn_u16(vshlq_u16(v, c->expShift));
+}
+
+static void microBmp_bitfield16ToRGB_neon(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  const microBmp_channel16_neon cr = microBmp_channel16Setup_neon(i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+  const microBmp_channel16_neon cg = microBmp_channel16Setup_neon(i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+  const microBmp_channel16_neon cb = microBmp_channel16Setup_neon(i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+  for (; x1 + 8 <= x2; x1 += 8) {
+    uint16x8_t  v = vreinterpretq_u16_u8(vld1q_u8(src));  /* byte load - the row may be unaligned */
+    uint8x8x3_t rgb;
+    rgb.val[0] = microBmp_expand16x8_neon(v, &cr);
+    rgb.val[1] = microBmp_expand16x8_neon(v, &cg);
+    rgb.val[2] = microBmp_expand16x8_neon(v, &cb);
+    vst3_u8(o_targetBuf, rgb);
+    o_targetBuf += 24;
+    src += 16;
+  }
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    o_targetBuf[0] = microBmp_expand16(c16, i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+    o_targetBuf[1] = microBmp_expand16(c16, i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+    o_targetBuf[2] = microBmp_expand16(c16, i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+    o_targetBuf += 3;
+    src += 2;
+  }
+}
+
+#endif
+
+
+void microBmp_selectConvertersNeon(microBmp_State* io_this)
+{
+  switch (io_this->pixelFormat) {
+#ifndef MBMP_BIG_ENDIAN
+    case MBMP_PIXFMT_BITFIELD16:
+    case MBMP_PIXFMT_RGB565:
+    case MBMP_PIXFMT_RGB555:
+      io_this->convertToRGB = microBmp_bitfield16ToRGB_neon;
+      break;
+#endif
+    case MBMP_PIXFMT_BGR24:
+      io_this->convertToRGB = microBmp_bgr24ToRGB_neon;
+      io_this->convertTo565 = microBmp_bgr24To565_neon;
+      break;
+    case MBMP_PIXFMT_BGRX32:
+      io_this->convertToRGB = microBmp_bgrx32ToRGB_neon;
+      io_this->convertTo565 = microBmp_bgrx32To565_neon;
+      break;
+    default:
+      break;
+  }
+}
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * SWAR (SIMD within a register) row converters for 32bit cores without a vector unit (e.g. Cortex-M0/M3/M4).
+ * The source row is read one 32bit word at a time instead of byte by byte and all channels of a pixel are
+ * extracted from that word with shift and mask operations.
+ * Only pixels that are part of [x1, x2[ are read, the remaining pixels are converted by a scalar tail.
+ */
+
+#include "microBmp_kernels.h"
+
+#ifdef MBMP_SIMD_SWAR
+
+#include <string.h>
+
+
+/**
+ * reads 4 bytes as little endian word (regardless of their alignment).
+ * On cores with unaligned access (Cortex-M3 and up) the memcpy compiles to a single ldr.
+ */
+static inline uint32_t microBmp_load32le(const uint8_t* p)
+{
+  uint32_t w;
+  memcpy(&w, p, sizeof(w));
+#ifdef MBMP_BIG_ENDIAN
+  w = (w >> 24) | ((w >> 8) & 0xFF00) | ((w << 8) & 0xFF0000) | (w << 24);
+#endif
+  return w;
+}
+
+/** converts a pixel stored in the low 24bits of w (B in bits 0..7, G in 8..15, R in 16..23) to RGB565 */
+static inline uint16_t microBmp_bgrWordTo565(uint32_t w)
+{
+  return (uint16_t)(((w >> 8) & 0xF800) | ((w >> 5) & 0x07E0) | ((w >> 3) & 0x001F));
+}
+
+
+/**
+ * 4 pixels are loaded with 3 words:
+ *   w0 = B0 G0 R0 B1,  w1 = G1 R1 B2 G2,  w2 = R2 B3 G3 R3  (lowest byte first)
+ */
+static void microBmp_bgr24To565_swar(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  (void)i_this;
+  for (; x1 + 4 <= x2; x1 += 4) {
+    uint32_t w0 = microBmp_load32le(src);
+    uint32_t w1 = microBmp_load32le(src + 4);
+    uint32_t w2 = microBmp_load32le(src + 8);
+    o_targetBuf[0] = microBmp_bgrWordTo565(w0);
+    o_targetBuf[1] = (uint16_t)( (w1 & 0xF800)         | ((w1 <<  3) & 0x07E0) | (w0 >> 27));
+    o_targetBuf[2] = (uint16_t)(((w2 <<  8) & 0xF800)  | ((w1 >> 21) & 0x07E0) | ((w1 >> 19) & 0x001F));
+    o_targetBuf[3] = (uint16_t)(((w2 >> 16) & 0xF800)  | ((w2 >> 13) & 0x07E0) | ((w2 >> 11) & 0x001F));
+    o_targetBuf += 4;
+    src += 12;
+  }
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_rgbTo565(src[2], src[1], src[0]);
+    src += 3;
+  }
+}
+
+static void microBmp_bgrx32To565_swar(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 + 2 <= x2; x1 += 2) {
+    uint32_t w0 = microBmp_load32le(src);
+    uint32_t w1 = microBmp_load32le(src + 4);
+    o_targetBuf[0] = microBmp_bgrWordTo565(w0);
+    o_targetBuf[1] = microBmp_bgrWordTo565(w1);
+    o_targetBuf += 2;
+    src += 8;
+  }
+  if (x1 < x2) {
+    *o_targetBuf = microBmp_bgrWordTo565(microBmp_load32le(src));
+  }
+}
+
+/** 2 pixels per word, same bit operations as microBmp_rgb555To565 applied to both halves at once */
+static void microBmp_rgb555To565_swar(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  (void)i_this;
+  for (; x1 + 2 <= x2; x1 += 2) {
+    uint32_t w = microBmp_load32le(src);
+    w = ((w & 0x7FE07FE0) << 1) | ((w >> 4) & 0x00200020) | (w & 0x001F001F);
+    o_targetBuf[0] = (uint16_t)w;
+    o_targetBuf[1] = (uint16_t)(w >> 16);
+    o_targetBuf += 2;
+    src += 4;
+  }
+  if (x1 < x2) {
+    uint16_t c16 = microBmp_read16(src);
+    *o_targetBuf = (uint16_t)(((c16 & 0x7FE0) << 1) | ((c16 >> 4) & 0x0020) | (c16 & 0x001F));
+  }
+}
+
+
+void microBmp_selectConvertersSwar(microBmp_State* io_this)
+{
+  switch (io_this->pixelFormat) {
+    case MBMP_PIXFMT_RGB555:
+      io_this->convertTo565 = microBmp_rgb555To565_swar;
+      break;
+    case MBMP_PIXFMT_BGR24:
+      io_this->convertTo565 = microBmp_bgr24To565_swar;
+      break;
+    case MBMP_PIXFMT_BGRX32:
+      io_this->convertTo565 = microBmp_bgrx32To565_swar;
+      break;
+    default:
+      break;
+  }
+}
+
+#endif
@@ -0,0 +1,647 @@
+/**
+ * SSE2/SSSE3/AVX2 row converters for x86 hosts.
+ * The instruction set is chosen at runtime, so the library can be built without any -m flags.
+ * Only pixels that are part of [x1, x2[ are read, the remaining pixels are converted by a scalar tail.
+ */
+
+#include "microBmp_kernels.h"
+
+#ifdef MBMP_SIMD_X86
+
+#include <string.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#  include <intrin.h>
+#  define MBMP_TARGET(isa)
+#else
+#  define MBMP_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+enum {
+  MBMP_X86_SSE2     = 1 << 0,
+  MBMP_X86_SSSE3    = 1 << 1,
+  MBMP_X86_AVX2     = 1 << 2,
+  MBMP_X86_DETECTED = 1 << 7
+};
+
+static unsigned microBmp_x86Features(void)
+{
+  static unsigned s_features = 0;
+  unsigned f = s_features;
+  if (f & MBMP_X86_DETECTED) {
+    return f;
+  }
+  f = MBMP_X86_DETECTED;
+#ifdef _MSC_VER
+  {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 1) {
+      __cpuid(info, 1);
+      if (info[3] & (1 << 26)) f |= MBMP_X86_SSE2;
+      if (info[2] & (1 <<  9)) f |= MBMP_X86_SSSE3;
+      /* AVX2 requires the OS to save the ymm registers (OSXSAVE + XCR0) */
+      if ((info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6)) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) f |= MBMP_X86_AVX2;
+      }
+    }
+  }
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))  f |= MBMP_X86_SSE2;
+  if (__builtin_cpu_supports("ssse3")) f |= MBMP_X86_SSSE3;
+  if (__builtin_cpu_supports("avx2"))  f |= MBMP_X86_AVX2;
+#endif
+  s_features = f;
+  return f;
+}
+
+
+/* scalar tails */
+
+static void microBmp_x86TailBgrToRGB(const uint8_t* src, uint8_t bytesPerPixel, uint8_t* o_targetBuf, uint16_t n)
+{
+  while (n--) {
+    o_targetBuf[0] = src[2];
+    o_targetBuf[1] = src[1];
+    o_targetBuf[2] = src[0];
+    o_targetBuf += 3;
+    src += bytesPerPixel;
+  }
+}
+
+static void microBmp_x86TailBgrTo565(const uint8_t* src, uint8_t bytesPerPixel, uint16_t* o_targetBuf, uint16_t n)
+{
+  while (n--) {
+    *o_targetBuf++ = microBmp_rgbTo565(src[2], src[1], src[0]);
+    src += bytesPerPixel;
+  }
+}
+
+/** palette of a 1 or 4 bit image split into byte planes for pshufb lookups */
+typedef struct {
+  uint8_t c0[16];   /**< r or low byte of the 565 color */
+  uint8_t c1[16];   /**< g or high byte of the 565 color */
+  uint8_t c2[16];   /**< b */
+} microBmp_x86SmallPalette;
+
+static void microBmp_x86SmallPaletteRGB(const microBmp_State* i_this, microBmp_x86SmallPalette* o_pal)
+{
+  uint16_t n = (i_this->colorsInPalette < 16) ? i_this->colorsInPalette : 16;
+  uint16_t i;
+  memset(o_pal, 0, sizeof(*o_pal));
+  for (i = 0; i < n; ++i) {
+    o_pal->c0[i] = i_this->palette[i * 4 + 2];
+    o_pal->c1[i] = i_this->palette[i * 4 + 1];
+    o_pal->c2[i] = i_this->palette[i * 4 + 0];
+  }
+}
+
+static void microBmp_x86SmallPalette565(const microBmp_State* i_this, microBmp_x86SmallPalette* o_pal)
+{
+  uint16_t n = (i_this->colorsInPalette < 16) ? i_this->colorsInPalette : 16;
+  uint16_t i;
+  memset(o_pal, 0, sizeof(*o_pal));
+  for (i = 0; i < n; ++i) {
+    const uint8_t* c = &i_this->palette[i * 4];
+    uint16_t v = i_this->paletteLut565 ? i_this->paletteLut565[i] : microBmp_rgbTo565(c[2], c[1], c[0]);
+    o_pal->c0[i] = (uint8_t)v;
+    o_pal->c1[i] = (uint8_t)(v >> 8);
+  }
+}
+
+size_t microBmp_x86PaletteBytes(const microBmp_State* i_this)
+{
+  if (((i_this->bitsPerPixel == 1) || (i_this->bitsPerPixel == 4)) && (microBmp_x86Features() & MBMP_X86_SSSE3)) {
+    return 2 * sizeof(microBmp_x86SmallPalette);   // RGB and 565 planes
+  }
+  return 0;
+}
+
+/** RGB (i_which 0) or 565 (i_which 1) planes, prepared at init or built into o_tmp if there was no room for them */
+static inline const microBmp_x86SmallPalette* microBmp_x86SmallPaletteOf(const microBmp_State* i_this, int i_which, microBmp_x86SmallPalette* o_tmp)
+{
+  if (i_this->paletteSimd) {
+    return (const microBmp_x86SmallPalette*)i_this->paletteSimd + i_which;
+  }
+  if (i_which) {
+    microBmp_x86SmallPalette565(i_this, o_tmp);
+  } else {
+    microBmp_x86SmallPaletteRGB(i_this, o_tmp);
+  }
+  return o_tmp;
+}
+
+/** palette index of pixel x in a 1 or 4 bit row (for the scalar head and tail pixels) */
+static inline uint8_t microBmp_x86Index(const uint8_t* row, uint8_t bitsPerPixel, uint16_t x)
+{
+  if (bitsPerPixel == 1) {
+    return (row[x >> 3] >> (7 - (x & 7))) & 1;
+  }
+  return (row[x >> 1] >> ((~x & 1) << 2)) & 0xF;
+}
+
+static inline uint8_t* microBmp_x86SmallPutRGB(uint8_t* o_targetBuf, const microBmp_x86SmallPalette* i_pal, uint8_t idx)
+{
+  o_targetBuf[0] = i_pal->c0[idx];
+  o_targetBuf[1] = i_pal->c1[idx];
+  o_targetBuf[2] = i_pal->c2[idx];
+  return o_targetBuf + 3;
+}
+
+static inline uint16_t microBmp_x86Small565(const microBmp_x86SmallPalette* i_pal, uint8_t idx)
+{
+  return (uint16_t)(i_pal->c0[idx] | (i_pal->c1[idx] << 8));
+}
+
+
+/* SSE2 */
+
+/** converts 4 BGRX pixels (one per 32bit lane) to RGB565 values in the lower 16bit of each lane (sign extended) */
+MBMP_TARGET("sse2")
+static inline __m128i microBmp_bgrxTo565x4_sse2(__m128i p)
+{
+  __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xF800));
+  __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07E0));
+  __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001F));
+  __m128i v = _mm_or_si128(_mm_or_si128(r, g), b);
+  /* sign extend, so that the saturating signed pack keeps the bit pattern */
+  return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+MBMP_TARGET("sse2")
+static void microBmp_bgrx32To565_sse2(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 + 8 <= x2; x1 += 8) {
+    __m128i p0 = microBmp_bgrxTo565x4_sse2(_mm_loadu_si128((const __m128i*)(src     )));
+    __m128i p1 = microBmp_bgrxTo565x4_sse2(_mm_loadu_si128((const __m128i*)(src + 16)));
+    _mm_storeu_si128((__m128i*)o_targetBuf, _mm_packs_epi32(p0, p1));
+    o_targetBuf += 8;
+    src += 32;
+  }
+  if (x1 < x2) {
+    microBmp_x86TailBgrTo565(src, 4, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+
+/* SSSE3 */
+
+MBMP_TARGET("ssse3")
+static void microBmp_bgr24ToRGB_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  const __m128i m00 = _mm_setr_epi8( 2,  1,  0,  5,  4,  3,  8,  7,  6, 11, 10,  9, 14, 13, 12, -1);
+  const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1);
+  const __m128i m10 = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i m11 = _mm_setr_epi8( 0, -1,  4,  3,  2,  7,  6,  5, 10,  9,  8, 13, 12, 11, -1, 15);
+  const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1);
+  const __m128i m21 = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i m22 = _mm_setr_epi8(-1,  3,  2,  1,  6,  5,  4,  9,  8,  7, 12, 11, 10, 15, 14, 13);
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    __m128i in0 = _mm_loadu_si128((const __m128i*)(src     ));
+    __m128i in1 = _mm_loadu_si128((const __m128i*)(src + 16));
+    __m128i in2 = _mm_loadu_si128((const __m128i*)(src + 32));
+    __m128i out0 = _mm_or_si128(_mm_shuffle_epi8(in0, m00), _mm_shuffle_epi8(in1, m01));
+    __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, m10), _mm_shuffle_epi8(in1, m11)), _mm_shuffle_epi8(in2, m12));
+    __m128i out2 = _mm_or_si128(_mm_shuffle_epi8(in1, m21), _mm_shuffle_epi8(in2, m22));
+    _mm_storeu_si128((__m128i*)(o_targetBuf     ), out0);
+    _mm_storeu_si128((__m128i*)(o_targetBuf + 16), out1);
+    _mm_storeu_si128((__m128i*)(o_targetBuf + 32), out2);
+    o_targetBuf += 48;
+    src += 48;
+  }
+  if (x1 < x2) {
+    microBmp_x86TailBgrToRGB(src, 3, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_bgrx32ToRGB_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  const __m128i m = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src     )), m);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), m);
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 32)), m);
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 48)), m);
+    _mm_storeu_si128((__m128i*)(o_targetBuf     ), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+    _mm_storeu_si128((__m128i*)(o_targetBuf + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+    _mm_storeu_si128((__m128i*)(o_targetBuf + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    o_targetBuf += 48;
+    src += 64;
+  }
+  if (x1 < x2) {
+    microBmp_x86TailBgrToRGB(src, 4, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_bgr24To565_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  const __m128i m = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  (void)i_this;
+  /* the second load reads 16 bytes at pixel 4, so 10 pixels have to be left to process 8 */
+  for (; x1 + 10 <= x2; x1 += 8) {
+    __m128i p0 = microBmp_bgrxTo565x4_sse2(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src     )), m));
+    __m128i p1 = microBmp_bgrxTo565x4_sse2(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 12)), m));
+    _mm_storeu_si128((__m128i*)o_targetBuf, _mm_packs_epi32(p0, p1));
+    o_targetBuf += 8;
+    src += 24;
+  }
+  if (x1 < x2) {
+    microBmp_x86TailBgrTo565(src, 3, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+/** shift, mask and expansion constants of one 16bit channel, see microBmp_State::expMulR */
+typedef struct {
+  __m128i shift;
+  __m128i mask;
+  __m128i mul;
+  __m128i expShift;
+} microBmp_channel16_sse;
+
+MBMP_TARGET("ssse3")
+static inline microBmp_channel16_sse microBmp_channel16Setup_ssse3(uint8_t shift, uint8_t mask, uint8_t mul, uint8_t expShift)
+{
+  microBmp_channel16_sse c;
+  c.shift    = _mm_cvtsi32_si128(shift);
+  c.mask     = _mm_set1_epi16(mask);
+  c.mul      = _mm_set1_epi16(mul);
+  c.expShift = _mm_cvtsi32_si128(expShift);
+  return c;
+}
+
+/** expands one 16bit channel of 8 pixels to 0..255 in 16bit lanes */
+MBMP_TARGET("ssse3")
+static inline __m128i microBmp_expand16x8_ssse3(__m128i v, const microBmp_channel16_sse* c)
+{
+  v = _mm_and_si128(_mm_srl_epi16(v, c->shift), c->mask);
+  v = _mm_mullo_epi16(v, c->mul);
+  return _mm_srl_epi16(v, c->expShift);
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_bitfield16ToRGB_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 2];
+  const __m128i mRG0 = _mm_setr_epi8( 0,  8, -1,  1,  9, -1,  2, 10, -1,  3, 11, -1,  4, 12, -1,  5);
+  const __m128i mB0  = _mm_setr_epi8(-1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1);
+  const __m128i mRG1 = _mm_setr_epi8(13, -1,  6, 14, -1,  7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i mB1  = _mm_setr_epi8(-1,  5, -1, -1,  6, -1, -1,  7, -1, -1, -1, -1, -1, -1, -1, -1);
+  const microBmp_channel16_sse cr = microBmp_channel16Setup_ssse3(i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+  const microBmp_channel16_sse cg = microBmp_channel16Setup_ssse3(i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+  const microBmp_channel16_sse cb = microBmp_channel16Setup_ssse3(i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+  for (; x1 + 8 <= x2; x1 += 8) {
+    __m128i v  = _mm_loadu_si128((const __m128i*)src);
+    __m128i r  = microBmp_expand16x8_ssse3(v, &cr);
+    __m128i g  = microBmp_expand16x8_ssse3(v, &cg);
+    __m128i b  = microBmp_expand16x8_ssse3(v, &cb);
+    __m128i rg = _mm_packus_epi16(r, g);
+    __m128i bb = _mm_packus_epi16(b, b);
+    _mm_storeu_si128((__m128i*)o_targetBuf, _mm_or_si128(_mm_shuffle_epi8(rg, mRG0), _mm_shuffle_epi8(bb, mB0)));
+    _mm_storel_epi64((__m128i*)(o_targetBuf + 16), _mm_or_si128(_mm_shuffle_epi8(rg, mRG1), _mm_shuffle_epi8(bb, mB1)));
+    o_targetBuf += 24;
+    src += 16;
+  }
+  for (; x1 < x2; ++x1) {
+    uint16_t c16 = microBmp_read16(src);
+    o_targetBuf[0] = microBmp_expand16(c16, i_this->shiftR, i_this->maskR, i_this->expMulR, i_this->expShiftR);
+    o_targetBuf[1] = microBmp_expand16(c16, i_this->shiftG, i_this->maskG, i_this->expMulG, i_this->expShiftG);
+    o_targetBuf[2] = microBmp_expand16(c16, i_this->shiftB, i_this->maskB, i_this->expMulB, i_this->expShiftB);
+    o_targetBuf += 3;
+    src += 2;
+  }
+}
+
+/** unpacks 2 bytes of 1bit indices into 16 indices */
+MBMP_TARGET("ssse3")
+static inline __m128i microBmp_unpack1_ssse3(const uint8_t* src)
+{
+  const __m128i bitsel = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+  __m128i v = _mm_cvtsi32_si128(src[0] | (src[1] << 8));
+  v = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1));
+  return _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v, bitsel), bitsel), _mm_set1_epi8(1));
+}
+
+/** unpacks 16 bytes of 4bit indices into 2x16 indices */
+MBMP_TARGET("ssse3")
+static inline void microBmp_unpack4_ssse3(const uint8_t* src, __m128i* o_idx0, __m128i* o_idx1)
+{
+  __m128i v  = _mm_loadu_si128((const __m128i*)src);
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+  __m128i lo = _mm_and_si128(v, _mm_set1_epi8(0x0F));
+  *o_idx0 = _mm_unpacklo_epi8(hi, lo);
+  *o_idx1 = _mm_unpackhi_epi8(hi, lo);
+}
+
+/** looks up 16 indices in the low/high byte tables and stores 16 RGB565 values */
+MBMP_TARGET("ssse3")
+static inline void microBmp_lookup565x16_ssse3(uint16_t* o_targetBuf, __m128i idx, __m128i lo, __m128i hi)
+{
+  __m128i l = _mm_shuffle_epi8(lo, idx);
+  __m128i h = _mm_shuffle_epi8(hi, idx);
+  _mm_storeu_si128((__m128i*)(o_targetBuf    ), _mm_unpacklo_epi8(l, h));
+  _mm_storeu_si128((__m128i*)(o_targetBuf + 8), _mm_unpackhi_epi8(l, h));
+}
+
+/** looks up 16 indices in the r, g and b tables and stores 16 interleaved RGB tuples */
+MBMP_TARGET("ssse3")
+static inline void microBmp_lookupRGBx16_ssse3(uint8_t* o_targetBuf, __m128i idx, __m128i tr, __m128i tg, __m128i tb)
+{
+  const __m128i m0R = _mm_setr_epi8( 0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5);
+  const __m128i m0G = _mm_setr_epi8(-1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1);
+  const __m128i m0B = _mm_setr_epi8(-1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1);
+  const __m128i m1R = _mm_setr_epi8(-1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1);
+  const __m128i m1G = _mm_setr_epi8( 5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10);
+  const __m128i m1B = _mm_setr_epi8(-1,  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1);
+  const __m128i m2R = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i m2G = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i m2B = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+  __m128i r = _mm_shuffle_epi8(tr, idx);
+  __m128i g = _mm_shuffle_epi8(tg, idx);
+  __m128i b = _mm_shuffle_epi8(tb, idx);
+  _mm_storeu_si128((__m128i*)(o_targetBuf     ), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m0R), _mm_shuffle_epi8(g, m0G)), _mm_shuffle_epi8(b, m0B)));
+  _mm_storeu_si128((__m128i*)(o_targetBuf + 16), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m1R), _mm_shuffle_epi8(g, m1G)), _mm_shuffle_epi8(b, m1B)));
+  _mm_storeu_si128((__m128i*)(o_targetBuf + 32), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m2R), _mm_shuffle_epi8(g, m2G)), _mm_shuffle_epi8(b, m2B)));
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_index1To565_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  microBmp_x86SmallPalette tmp;
+  const microBmp_x86SmallPalette* pal;
+  __m128i lo, hi;
+  pal = microBmp_x86SmallPaletteOf(i_this, 1, &tmp);
+  lo = _mm_loadu_si128((const __m128i*)pal->c0);
+  hi = _mm_loadu_si128((const __m128i*)pal->c1);
+  for (; (x1 & 7) && (x1 < x2); ++x1) {
+    *o_targetBuf++ = microBmp_x86Small565(pal, microBmp_x86Index(i_row, 1, x1));
+  }
+  for (; x1 + 16 <= x2; x1 += 16) {
+    microBmp_lookup565x16_ssse3(o_targetBuf, microBmp_unpack1_ssse3(&i_row[x1 >> 3]), lo, hi);
+    o_targetBuf += 16;
+  }
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_x86Small565(pal, microBmp_x86Index(i_row, 1, x1));
+  }
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_index1ToRGB_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  microBmp_x86SmallPalette tmp;
+  const microBmp_x86SmallPalette* pal;
+  __m128i tr, tg, tb;
+  pal = microBmp_x86SmallPaletteOf(i_this, 0, &tmp);
+  tr = _mm_loadu_si128((const __m128i*)pal->c0);
+  tg = _mm_loadu_si128((const __m128i*)pal->c1);
+  tb = _mm_loadu_si128((const __m128i*)pal->c2);
+  for (; (x1 & 7) && (x1 < x2); ++x1) {
+    o_targetBuf = microBmp_x86SmallPutRGB(o_targetBuf, pal, microBmp_x86Index(i_row, 1, x1));
+  }
+  for (; x1 + 16 <= x2; x1 += 16) {
+    microBmp_lookupRGBx16_ssse3(o_targetBuf, microBmp_unpack1_ssse3(&i_row[x1 >> 3]), tr, tg, tb);
+    o_targetBuf += 48;
+  }
+  for (; x1 < x2; ++x1) {
+    o_targetBuf = microBmp_x86SmallPutRGB(o_targetBuf, pal, microBmp_x86Index(i_row, 1, x1));
+  }
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_index4To565_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  microBmp_x86SmallPalette tmp;
+  const microBmp_x86SmallPalette* pal;
+  __m128i lo, hi, idx0, idx1;
+  pal = microBmp_x86SmallPaletteOf(i_this, 1, &tmp);
+  lo = _mm_loadu_si128((const __m128i*)pal->c0);
+  hi = _mm_loadu_si128((const __m128i*)pal->c1);
+  if ((x1 & 1) && (x1 < x2)) {
+    *o_targetBuf++ = microBmp_x86Small565(pal, microBmp_x86Index(i_row, 4, x1));
+    ++x1;
+  }
+  for (; x1 + 32 <= x2; x1 += 32) {
+    microBmp_unpack4_ssse3(&i_row[x1 >> 1], &idx0, &idx1);
+    microBmp_lookup565x16_ssse3(o_targetBuf,      idx0, lo, hi);
+    microBmp_lookup565x16_ssse3(o_targetBuf + 16, idx1, lo, hi);
+    o_targetBuf += 32;
+  }
+  for (; x1 < x2; ++x1) {
+    *o_targetBuf++ = microBmp_x86Small565(pal, microBmp_x86Index(i_row, 4, x1));
+  }
+}
+
+MBMP_TARGET("ssse3")
+static void microBmp_index4ToRGB_ssse3(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  microBmp_x86SmallPalette tmp;
+  const microBmp_x86SmallPalette* pal;
+  __m128i tr, tg, tb, idx0, idx1;
+  pal = microBmp_x86SmallPaletteOf(i_this, 0, &tmp);
+  tr = _mm_loadu_si128((const __m128i*)pal->c0);
+  tg = _mm_loadu_si128((const __m128i*)pal->c1);
+  tb = _mm_loadu_si128((const __m128i*)pal->c2);
+  if ((x1 & 1) && (x1 < x2)) {
+    o_targetBuf = microBmp_x86SmallPutRGB(o_targetBuf, pal, microBmp_x86Index(i_row, 4, x1));
+    ++x1;
+  }
+  for (; x1 + 32 <= x2; x1 += 32) {
+    microBmp_unpack4_ssse3(&i_row[x1 >> 1], &idx0, &idx1);
+    microBmp_lookupRGBx16_ssse3(o_targetBuf,      idx0, tr, tg, tb);
+    microBmp_lookupRGBx16_ssse3(o_targetBuf + 48, idx1, tr, tg, tb);
+    o_targetBuf += 96;
+  }
+  for (; x1 < x2; ++x1) {
+    o_targetBuf = microBmp_x86SmallPutRGB(o_targetBuf, pal, microBmp_x86Index(i_row, 4, x1));
+  }
+}
+
+
+/* AVX2 */
+
+/** converts 8 BGRX pixels (one per 32bit lane) to RGB565 values in the lower 16bit of each lane (sign extended) */
+MBMP_TARGET("avx2")
+static inline __m256i microBmp_bgrxTo565x8_avx2(__m256i p)
+{
+  __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xF800));
+  __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x07E0));
+  __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x001F));
+  __m256i v = _mm256_or_si256(_mm256_or_si256(r, g), b);
+  return _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+}
+
+/** packs 2x8 converted pixels to 16 RGB565 values in pixel order (the pack works per 128bit lane) */
+MBMP_TARGET("avx2")
+static inline __m256i microBmp_pack565x16_avx2(__m256i p0, __m256i p1)
+{
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(p0, p1), 0xD8);
+}
+
+MBMP_TARGET("avx2")
+static void microBmp_bgrx32To565_avx2(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 4];
+  (void)i_this;
+  for (; x1 + 16 <= x2; x1 += 16) {
+    __m256i p0 = microBmp_bgrxTo565x8_avx2(_mm256_loadu_si256((const __m256i*)(src     )));
+    __m256i p1 = microBmp_bgrxTo565x8_avx2(_mm256_loadu_si256((const __m256i*)(src + 32)));
+    _mm256_storeu_si256((__m256i*)o_targetBuf, microBmp_pack565x16_avx2(p0, p1));
+    o_targetBuf += 16;
+    src += 64;
+  }
+  if (x1 < x2) {
+    microBmp_x86TailBgrTo565(src, 4, o_targetBuf, (uint16_t)(x2 - x1));
+  }
+}
+
+MBMP_TARGET("avx2")
+static void microBmp_bgr24To565_avx2(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1 * 3];
+  /* move pixel 0-3 into the low and pixel 4-7 into the high lane, then spread them to one pixel per 32bit */
+  const __m256i perm = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+  const __m256i m    = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  /* the second load reads 32 bytes at pixel 8, so 19 pixels have to be left to process 16 */
+  for (; x1 + 19 <= x2; x1 += 16) {
+    __m256i in0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(src     )), perm);
+    __m256i in1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(src + 24)), perm);
+    __m256i p0  = microBmp_bgrxTo565x8_avx2(_mm256_shuffle_epi8(in0, m));
+    __m256i p1  = microBmp_bgrxTo565x8_avx2(_mm256_shuffle_epi8(in1, m));
+    _mm256_storeu_si256((__m256i*)o_targetBuf, microBmp_pack565x16_avx2(p0, p1));
+    o_targetBuf += 16;
+    src += 48;
+  }
+  if (x1 < x2) {
+    microBmp_bgr24To565_ssse3(i_this, i_row, o_targetBuf, x1, x2);
+  }
+}
+
+/** gathers 8 BGRA palette entries for the 8 indices at src */
+MBMP_TARGET("avx2")
+static inline __m256i microBmp_gatherPalette8_avx2(const microBmp_State* i_this, const uint8_t* src)
+{
+  __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+  return _mm256_i32gather_epi32((const int*)i_this->palette, idx, 4);
+}
+
+MBMP_TARGET("avx2")
+static void microBmp_index8To565_avx2(const microBmp_State* i_this, const uint8_t* i_row, uint16_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src = &i_row[x1];
+  for (; x1 + 16 <= x2; x1 += 16) {
+    __m256i p0 = microBmp_bgrxTo565x8_avx2(microBmp_gatherPalette8_avx2(i_this, src    ));
+    __m256i p1 = microBmp_bgrxTo565x8_avx2(microBmp_gatherPalette8_avx2(i_this, src + 8));
+    _mm256_storeu_si256((__m256i*)o_targetBuf, microBmp_pack565x16_avx2(p0, p1));
+    o_targetBuf += 16;
+    src += 16;
+  }
+  for (; x1 < x2; ++x1) {
+    const uint8_t* c = &i_this->palette[*src++ * 4];
+    *o_targetBuf++ = microBmp_rgbTo565(c[2], c[1], c[0]);
+  }
+}
+
+MBMP_TARGET("avx2")
+static void microBmp_index8ToRGB_avx2(const microBmp_State* i_this, const uint8_t* i_row, uint8_t* o_targetBuf, uint16_t x1, uint16_t x2)
+{
+  const uint8_t* src  = &i_row[x1];
+  const __m256i  m    = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i  perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  for (; x1 + 8 <= x2; x1 += 8) {
+    /* 4 RGB tuples per lane, then move the 24 used bytes together */
+    __m256i rgb = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(microBmp_gatherPalette8_avx2(i_this, src), m), perm);
+    _mm_storeu_si128((__m128i*)o_targetBuf, _mm256_castsi256_si128(rgb));
+    _mm_storel_epi64((__m128i*)(o_targetBuf + 16), _mm256_extracti128_si256(rgb, 1));
+    o_targetBuf += 24;
+    src += 8;
+  }
+  for (; x1 < x2; ++x1) {
+    const uint8_t* c = &i_this->palette[*src++ * 4];
+    o_targetBuf[0] = c[2];
+    o_targetBuf[1] = c[1];
+    o_targetBuf[2] = c[0];
+    o_targetBuf += 3;
+  }
+}
+
+
+/** splits the palette once into the area taken at init (the 565 planes use paletteLut565 if there is one) */
+static void microBmp_x86FillPalette(microBmp_State* io_this)
+{
+  if (io_this->paletteSimd) {
+    microBmp_x86SmallPaletteRGB(io_this, (microBmp_x86SmallPalette*)io_this->paletteSimd);
+    microBmp_x86SmallPalette565(io_this, (microBmp_x86SmallPalette*)io_this->paletteSimd + 1);
+  }
+}
+
+void microBmp_selectConvertersX86(microBmp_State* io_this)
+{
+  unsigned f = microBmp_x86Features();
+  switch (io_this->pixelFormat) {
+    case MBMP_PIXFMT_INDEX1:
+      if (f & MBMP_X86_SSSE3) {
+        microBmp_x86FillPalette(io_this);
+        io_this->convertToRGB = microBmp_index1ToRGB_ssse3;
+        io_this->convertTo565 = microBmp_index1To565_ssse3;
+      }
+      break;
+    case MBMP_PIXFMT_INDEX4:
+      if (f & MBMP_X86_SSSE3) {
+        microBmp_x86FillPalette(io_this);
+        io_this->convertToRGB = microBmp_index4ToRGB_ssse3;
+        io_this->convertTo565 = microBmp_index4To565_ssse3;
+      }
+      break;
+    case MBMP_PIXFMT_INDEX8:
+      if ((f & MBMP_X86_AVX2) && !io_this->paletteLutRGB) {   // a requested lookup table is a plain load per pixel, faster than the gather
+        io_this->convertToRGB = microBmp_index8ToRGB_avx2;
+      }
+      if ((f & MBMP_X86_AVX2) && !io_this->paletteLut565) {
+        io_this->convertTo565 = microBmp_index8To565_avx2;
+      }
+      break;
+    case MBMP_PIXFMT_BITFIELD16:
+    case MBMP_PIXFMT_RGB565:
+    case MBMP_PIXFMT_RGB555:
+      if (f & MBMP_X86_SSSE3) {
+        io_this->convertToRGB = microBmp_bitfield16ToRGB_ssse3;
+      }
+      break;
+    case MBMP_PIXFMT_BGR24:
+      if (f & MBMP_X86_SSSE3) {
+        io_this->convertToRGB = microBmp_bgr24ToRGB_ssse3;
+        io_this->convertTo565 = microBmp_bgr24To565_ssse3;
+      }
+      if (f & MBMP_X86_AVX2) {
+        io_this->convertTo565 = microBmp_bgr24To565_avx2;
+      }
+      break;
+    case MBMP_PIXFMT_BGRX32:
+      if (f & MBMP_X86_SSE2) {
+        io_this->convertTo565 = microBmp_bgrx32To565_sse2;
+      }
+      if (f & MBMP_X86_SSSE3) {
+        io_this->convertToRGB = microBmp_bgrx32ToRGB_ssse3;
+      }
+      if (f & MBMP_X86_AVX2) {
+        io_this->convertTo565 = microBmp_bgrx32To565_avx2;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+#endif
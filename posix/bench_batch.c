@@ -0,0 +1,155 @@
+/**
+ * compares microBmp_batchDecode with decoding the files one after another through a plain pread loadDataFunc.
+ * Both variants convert every row to RGB565 and sum up a checksum, so they can be cross checked.
+ * The files are dropped from the page cache before each pass (unless -w is given), so the reads hit the disk.
+ *
+ * build:  gcc -O2 -o bench_batch bench_batch.c microBmp_uring.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ * usage:  bench_batch [-q queueDepth] [-b bufferSize] [-r repeats] [-w] file.bmp ...
+ */
+
+#define _GNU_SOURCE
+#include "microBmp_uring.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint16_t s_row565[65536];
+static uint64_t s_checksum;
+static uint64_t s_bytes;
+
+static void rowChecksum(microBmp_State* i_bmp, uint16_t i_y)
+{
+  uint64_t h = 1469598103934665603ULL ^ i_y;
+  uint16_t x;
+  microBmp_convertRowTo565(i_bmp, s_row565, 0, i_bmp->imageWidth);
+  for (x = 0; x < i_bmp->imageWidth; ++x) {
+    h = (h ^ s_row565[x]) * 1099511628211ULL;
+  }
+  s_checksum += h;                              // order independent - the batch finishes files in any order
+  s_bytes    += i_bmp->bytesPerRow;
+}
+
+/** loadDataFunc of the one by one decoding, bytes behind the end of the file are zero filled */
+static void preadLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  int      fd  = *(int*)io_userData;
+  uint8_t* dst = (uint8_t*)o_buffer;
+  ssize_t  r   = pread(fd, dst, i_numBytes, i_offset);
+  if (r < 0) {
+    r = 0;
+  }
+  memset(dst + r, 0, i_numBytes - (size_t)r);
+}
+
+static int decodePread(const char* const* i_paths, int i_num, uint32_t i_bufferSize)
+{
+  uint8_t* buffer = (uint8_t*)malloc(i_bufferSize);
+  int      failed = 0;
+  int      i;
+  for (i = 0; i < i_num; ++i) {
+    microBmp_State bmp;
+    int            fd = open(i_paths[i], O_RDONLY | O_CLOEXEC);
+    if ((fd < 0) || (microBmp_init(&bmp, buffer, i_bufferSize, preadLoad, &fd) != MBMP_STATUS_OK)) {
+      ++failed;
+    } else {
+      while (microBmp_getNextRow(&bmp)) {
+        rowChecksum(&bmp, (uint16_t)(bmp.currentRow - 1));
+      }
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  free(buffer);
+  return failed;
+}
+
+static void batchRow(microBmp_State* i_bmp, const uint8_t* i_row, uint16_t i_y, void* io_userData)
+{
+  (void)i_row;
+  (void)io_userData;
+  rowChecksum(i_bmp, i_y);
+}
+
+static void dropCache(const char* const* i_paths, int i_num)
+{
+  int i;
+  for (i = 0; i < i_num; ++i) {
+    int fd = open(i_paths[i], O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* i_name, double i_seconds, int i_files)
+{
+  printf("%-8s %8.3f ms  %8.1f files/s  %8.1f MiB/s  checksum %016llx\n", i_name, i_seconds * 1e3,
+         i_files / i_seconds, (double)s_bytes / (1024.0 * 1024.0) / i_seconds, (unsigned long long)s_checksum);
+}
+
+int main(int argc, char** argv)
+{
+  microBmp_BatchConfig    cfg  = { 32, 0, 64 * 1024, 0 };
+  microBmp_BatchCallbacks cb   = { batchRow, NULL, NULL };
+  microBmp_BatchStats     stats;
+  int                     repeats = 3;
+  int                     warm    = 0;
+  int                     opt, r;
+  while ((opt = getopt(argc, argv, "q:b:r:w")) != -1) {
+    switch (opt) {
+      case 'q': cfg.queueDepth = (uint16_t)atoi(optarg); break;
+      case 'b': cfg.bufferSize = (uint32_t)atoi(optarg); break;
+      case 'r': repeats = atoi(optarg);                  break;
+      case 'w': warm = 1;                                break;
+      default:
+        fprintf(stderr, "usage: %s [-q queueDepth] [-b bufferSize] [-r repeats] [-w] file.bmp ...\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "no files\n");
+    return 2;
+  }
+  const char* const* paths = (const char* const*)&argv[optind];
+  int                num   = argc - optind;
+
+  for (r = 0; r < repeats; ++r) {
+    double t;
+    int    failed;
+
+    if (!warm) {
+      dropCache(paths, num);
+    }
+    s_checksum = s_bytes = 0;
+    t = now();
+    failed = decodePread(paths, num, cfg.bufferSize);
+    report("pread", now() - t, num - failed);
+
+    if (!warm) {
+      dropCache(paths, num);
+    }
+    s_checksum = s_bytes = 0;
+    t = now();
+    if (microBmp_batchDecode(paths, (uint32_t)num, &cfg, &cb, &stats) != 0) {
+      fprintf(stderr, "io_uring setup failed\n");
+      return 1;
+    }
+    report("io_uring", now() - t, (int)stats.filesDone);
+    printf("         %u reads, %u synchronous, up to %u in flight, %u failed\n",
+           stats.reads, stats.syncReads, stats.maxInFlight, stats.filesFailed);
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * compares the throughput of the sources of microBmp_source.h on a list of files.
+ * Every variant converts all rows to RGB565 and sums up a checksum, so they can be cross checked.
+ * The files are dropped from the page cache before each pass (unless -w is given), so the reads hit the disk.
+ *
+ * build:  gcc -O2 -o bench_sources bench_sources.c microBmp_source.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ * usage:  bench_sources [-b bufferSize] [-r repeats] [-w] file.bmp ...
+ */
+
+#define _GNU_SOURCE
+#include "microBmp_source.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+  const char*         name;
+  microBmp_SourceType type;
+  uint32_t            flags;
+  int                 copy;          /**< do not use the mapped rows in place */
+} Variant;
+
+static const Variant s_variants[] = {
+  { "pread",         MBMP_SOURCE_PREAD,  MBMP_SOURCE_DEFAULT, 0 },
+  { "pread+advise",  MBMP_SOURCE_PREAD,  MBMP_SOURCE_ADVISE,  0 },
+  { "mmap copy",     MBMP_SOURCE_MMAP,   MBMP_SOURCE_DEFAULT, 1 },
+  { "mmap",          MBMP_SOURCE_MMAP,   MBMP_SOURCE_DEFAULT, 0 },
+  { "mmap+advise",   MBMP_SOURCE_MMAP,   MBMP_SOURCE_ADVISE,  0 },
+  { "O_DIRECT",      MBMP_SOURCE_DIRECT, MBMP_SOURCE_DEFAULT, 0 },
+};
+
+static uint16_t s_row565[65536];
+
+static uint64_t decode(const Variant* i_var, const char* const* i_paths, int i_num, uint8_t* io_buffer, uint32_t i_bufferSize,
+                       uint64_t* o_bytes, microBmp_SourceStats* o_stats)
+{
+  uint64_t checksum = 0;
+  int      i;
+  memset(o_stats, 0, sizeof(*o_stats));
+  *o_bytes = 0;
+  for (i = 0; i < i_num; ++i) {
+    microBmp_State       bmp;
+    microBmp_SourceStats st;
+    microBmp_Source*     src = microBmp_sourceOpen(i_paths[i], i_var->type, i_var->flags);
+    if (!src) {
+      continue;
+    }
+    if (microBmp_sourceInit(src, &bmp, io_buffer, i_bufferSize, MBMP_INIT_DEFAULT) == MBMP_STATUS_OK) {
+      if (i_var->copy) {
+        microBmp_setMapDataFunc(&bmp, NULL);
+      }
+      while (microBmp_getNextRow(&bmp)) {
+        uint64_t h = 1469598103934665603ULL ^ (bmp.currentRow - 1);
+        uint16_t x;
+        microBmp_convertRowTo565(&bmp, s_row565, 0, bmp.imageWidth);
+        for (x = 0; x < bmp.imageWidth; ++x) {
+          h = (h ^ s_row565[x]) * 1099511628211ULL;
+        }
+        checksum += h;
+        *o_bytes += bmp.bytesPerRow;
+      }
+    }
+    microBmp_sourceGetStats(src, &st);
+    o_stats->loads     += st.loads;
+    o_stats->maps      += st.maps;
+    o_stats->bounced   += st.bounced;
+    o_stats->hints     += st.hints;
+    o_stats->bytesRead += st.bytesRead;
+    o_stats->alignment  = st.alignment;
+    microBmp_sourceClose(src);
+  }
+  return checksum;
+}
+
+static void dropCache(const char* const* i_paths, int i_num)
+{
+  int i;
+  for (i = 0; i < i_num; ++i) {
+    int fd = open(i_paths[i], O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t bufferSize = 64 * 1024;
+  int      repeats    = 3;
+  int      warm       = 0;
+  int      opt, r;
+  size_t   v;
+  uint8_t* buffer;
+  while ((opt = getopt(argc, argv, "b:r:w")) != -1) {
+    switch (opt) {
+      case 'b': bufferSize = (uint32_t)atoi(optarg); break;
+      case 'r': repeats = atoi(optarg);              break;
+      case 'w': warm = 1;                            break;
+      default:
+        fprintf(stderr, "usage: %s [-b bufferSize] [-r repeats] [-w] file.bmp ...\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "no files\n");
+    return 2;
+  }
+  const char* const* paths = (const char* const*)&argv[optind];
+  int                num   = argc - optind;
+  buffer = (uint8_t*)aligned_alloc(4096, (bufferSize + 4095) & ~4095u);   // lets O_DIRECT read aligned blocks in place
+
+  for (r = 0; r < repeats; ++r) {
+    for (v = 0; v < sizeof(s_variants) / sizeof(s_variants[0]); ++v) {
+      microBmp_SourceStats st;
+      uint64_t             bytes, checksum;
+      double               t;
+      if (!warm) {
+        dropCache(paths, num);
+      }
+      t        = now();
+      checksum = decode(&s_variants[v], paths, num, buffer, bufferSize, &bytes, &st);
+      t        = now() - t;
+      printf("%-13s %9.3f ms %9.1f MiB/s  checksum %016llx  loads %u maps %u hints %u bounced %u read %.1f MiB (align %u)\n",
+             s_variants[v].name, t * 1e3, (double)bytes / (1024.0 * 1024.0) / t, (unsigned long long)checksum,
+             st.loads, st.maps, st.hints, st.bounced, (double)st.bytesRead / (1024.0 * 1024.0), st.alignment);
+    }
+  }
+  free(buffer);
+  return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * read-ahead source, see microBmp_readahead.h
+ *
+ * Block k of the ring covers the file range [dataEnd - (k+1)*blockSize, dataEnd - k*blockSize[ (clipped to dataStart)
+ * or [dataStart + k*blockSize, dataStart + (k+1)*blockSize[ (clipped to dataEnd) for top down images and
+ * MBMP_INIT_FILE_ORDER, that are decoded from the start of the file on. It is stored in slot k % depth.
+ * head is the number of blocks published by the producer, tail the number of blocks released by the consumer.
+ * Both sides only block (futex) if the ring is full or empty. The thread then sleeps until half of the ring is released,
+ * so the decoder wakes it once per half ring instead of for every block it releases.
+ */
+
+#ifdef __linux__
+
+#define _GNU_SOURCE
+#include "microBmp_readahead.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct microBmp_ReadAhead {
+  int          fd;
+  uint32_t     blockSize;
+  uint32_t     depth;
+  uint8_t*     ring;
+  uint32_t     dataStart;          /**< file offset of the first image data byte */
+  uint32_t     dataEnd;            /**< file offset behind the last image data byte */
+  uint32_t     numBlocks;
+  int          forward;            /**< blocks are numbered from dataStart on (top down image or file order) */
+  pthread_t    thread;
+  int          started;
+  atomic_uint  head;
+  atomic_uint  tail;
+  atomic_uint  stop;
+  atomic_uint  producerWaiting;    /**< tail at which the sleeping thread wants to be woken, 0 - not sleeping */
+  atomic_uint  consumerWaiting;
+  atomic_uint  blocksRead;
+  uint32_t     stalls;
+  uint32_t     directReads;
+};
+
+
+static void microBmp_raWait(atomic_uint* i_addr, unsigned i_val)
+{
+  syscall(SYS_futex, (void*)i_addr, FUTEX_WAIT_PRIVATE, i_val, NULL, NULL, 0);
+}
+
+static void microBmp_raWake(atomic_uint* i_addr)
+{
+  syscall(SYS_futex, (void*)i_addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/** reads n bytes at i_offset, missing bytes are zero filled */
+static void microBmp_raRead(int fd, uint8_t* o_buffer, uint32_t n, uint32_t i_offset)
+{
+  int64_t off = i_offset;
+  while (n > 0) {
+    ssize_t r = pread(fd, o_buffer, n, off);
+    if (r <= 0) {
+      memset(o_buffer, 0, n);
+      return;
+    }
+    o_buffer += r;
+    n        -= (uint32_t)r;
+    off      += r;
+  }
+}
+
+/** file range of block k */
+static void microBmp_raBlockRange(const microBmp_ReadAhead* i_ra, uint32_t k, uint32_t* o_begin, uint32_t* o_end)
+{
+  if (i_ra->forward) {
+    uint32_t begin = i_ra->dataStart + k * i_ra->blockSize;
+    *o_begin = begin;
+    *o_end   = (i_ra->dataEnd - begin > i_ra->blockSize) ? begin + i_ra->blockSize : i_ra->dataEnd;
+  } else {
+    uint32_t end = i_ra->dataEnd - k * i_ra->blockSize;
+    *o_end   = end;
+    *o_begin = (end - i_ra->dataStart > i_ra->blockSize) ? end - i_ra->blockSize : i_ra->dataStart;
+  }
+}
+
+/** block that holds the image data byte at i_offset */
+static uint32_t microBmp_raBlockOf(const microBmp_ReadAhead* i_ra, uint32_t i_offset)
+{
+  if (i_ra->forward) {
+    return (i_offset - i_ra->dataStart) / i_ra->blockSize;
+  }
+  return (i_ra->dataEnd - 1 - i_offset) / i_ra->blockSize;
+}
+
+static void* microBmp_raThread(void* io_arg)
+{
+  microBmp_ReadAhead* ra     = (microBmp_ReadAhead*)io_arg;
+  uint32_t            refill = (ra->depth + 1) / 2;    // blocks that have to be free before a full ring is filled again
+  uint32_t k;
+  for (k = 0; ; ++k) {
+    uint32_t begin, end;
+    for (;;) {
+      unsigned tail = atomic_load(&ra->tail);
+      unsigned resume;
+      if (atomic_load(&ra->stop)) {
+        return NULL;
+      }
+      if (k < tail) {                                  // released without being used (the decoder skipped them)
+        k = tail;
+      }
+      if (k - tail < ra->depth) {
+        break;
+      }
+      resume = k - ra->depth + refill;                 // ring full
+      atomic_store(&ra->producerWaiting, resume);
+      tail = atomic_load(&ra->tail);
+      if ((tail < resume) && (k - tail >= ra->depth)) { // the decoder may have released blocks without seeing resume
+        microBmp_raWait(&ra->tail, tail);
+      }
+      atomic_store(&ra->producerWaiting, 0);
+    }
+    if (k >= ra->numBlocks) {
+      break;
+    }
+    microBmp_raBlockRange(ra, k, &begin, &end);
+    microBmp_raRead(ra->fd, ra->ring + (size_t)(k % ra->depth) * ra->blockSize, end - begin, begin);
+    atomic_fetch_add(&ra->blocksRead, 1);
+    atomic_store(&ra->head, k + 1);
+    if (atomic_load(&ra->consumerWaiting)) {
+      microBmp_raWake(&ra->head);
+    }
+  }
+  return NULL;
+}
+
+
+microBmp_ReadAhead* microBmp_readAheadOpen(const char* i_path, const microBmp_ReadAheadConfig* i_config)
+{
+  microBmp_ReadAhead* ra = (microBmp_ReadAhead*)calloc(1, sizeof(microBmp_ReadAhead));
+  if (!ra) {
+    return NULL;
+  }
+  ra->blockSize = (i_config && i_config->blockSize) ? i_config->blockSize : 64 * 1024;
+  ra->depth     = (i_config && i_config->depth)     ? i_config->depth     : 8;
+  ra->ring      = (uint8_t*)malloc((size_t)ra->blockSize * ra->depth);
+  ra->fd        = open(i_path, O_RDONLY | O_CLOEXEC);
+  if (!ra->ring || (ra->fd < 0)) {
+    if (ra->fd >= 0) {
+      close(ra->fd);
+    }
+    free(ra->ring);
+    free(ra);
+    return NULL;
+  }
+  return ra;
+}
+
+int microBmp_readAheadStart(microBmp_ReadAhead* io_ra, const microBmp_State* i_bmp)
+{
+  if (io_ra->started) {
+    return -1;
+  }
+  io_ra->dataEnd   = i_bmp->endOfImage;
+  io_ra->dataStart = i_bmp->endOfImage - i_bmp->bytesPerRow * i_bmp->imageHeight;
+  io_ra->numBlocks = (io_ra->dataEnd - io_ra->dataStart + io_ra->blockSize - 1) / io_ra->blockSize;
+  io_ra->forward   = i_bmp->topDown || i_bmp->fileOrder;
+  (void)posix_fadvise(io_ra->fd, io_ra->dataStart, io_ra->dataEnd - io_ra->dataStart, POSIX_FADV_SEQUENTIAL);
+  if (pthread_create(&io_ra->thread, NULL, microBmp_raThread, io_ra) != 0) {
+    return -1;
+  }
+  io_ra->started = 1;
+  return 0;
+}
+
+/** copies [i_offset, i_offset + i_numBytes[ (inside the image data) from the ring, returns 0 if it is not (or no longer) covered by it */
+static int microBmp_raFromRing(microBmp_ReadAhead* io_ra, uint8_t* o_buffer, uint32_t i_numBytes, uint32_t i_offset)
+{
+  /* blocks holding the first and the last requested byte */
+  uint32_t kLo = microBmp_raBlockOf(io_ra, i_offset);
+  uint32_t kHi = microBmp_raBlockOf(io_ra, i_offset + i_numBytes - 1);
+  uint32_t k;
+  unsigned resume;
+  if (kLo > kHi) {
+    k   = kLo;
+    kLo = kHi;
+    kHi = k;
+  }
+  if ((kLo < atomic_load(&io_ra->tail)) || (kHi - kLo >= io_ra->depth)) {   // already released (seek) or larger than the ring
+    return 0;
+  }
+
+  /* blocks in front of kLo are behind the decoder - release them for the thread, that is only woken once enough blocks
+     are free or if the decoder would have to wait for it */
+  atomic_store(&io_ra->tail, kLo);
+  resume = atomic_load(&io_ra->producerWaiting);
+  if (resume && ((kLo >= resume) || (atomic_load(&io_ra->head) <= kHi))) {
+    microBmp_raWake(&io_ra->tail);
+  }
+  if (atomic_load(&io_ra->head) <= kHi) {
+    ++io_ra->stalls;
+    for (;;) {
+      unsigned head = atomic_load(&io_ra->head);
+      if (head > kHi) {
+        break;
+      }
+      atomic_store(&io_ra->consumerWaiting, 1);
+      if (atomic_load(&io_ra->head) == head) {
+        microBmp_raWait(&io_ra->head, head);
+      }
+      atomic_store(&io_ra->consumerWaiting, 0);
+    }
+  }
+
+  for (k = kLo; k <= kHi; ++k) {
+    uint32_t       begin, end;
+    uint32_t       from, to;
+    const uint8_t* slot = io_ra->ring + (size_t)(k % io_ra->depth) * io_ra->blockSize;
+    microBmp_raBlockRange(io_ra, k, &begin, &end);
+    from = (i_offset > begin) ? i_offset : begin;
+    to   = (i_offset + i_numBytes < end) ? i_offset + i_numBytes : end;
+    memcpy(o_buffer + (from - i_offset), slot + (from - begin), to - from);
+  }
+  return 1;
+}
+
+void microBmp_readAheadLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  microBmp_ReadAhead* ra  = (microBmp_ReadAhead*)io_userData;
+  uint8_t*            out = (uint8_t*)o_buffer;
+  int64_t             lo  = i_offset;
+  int64_t             hi  = lo + i_numBytes;
+  int64_t             rlo = (lo > ra->dataStart) ? lo : ra->dataStart;
+  int64_t             rhi = (hi < ra->dataEnd)   ? hi : ra->dataEnd;
+  if (!ra->started || (rlo >= rhi) || !microBmp_raFromRing(ra, out + (rlo - lo), (uint32_t)(rhi - rlo), (uint32_t)rlo)) {
+    ++ra->directReads;
+    microBmp_raRead(ra->fd, out, i_numBytes, i_offset);
+    return;
+  }
+  if ((lo < rlo) || (rhi < hi)) {                   // parts outside of the image data
+    ++ra->directReads;
+    if (lo < rlo) {
+      microBmp_raRead(ra->fd, out, (uint32_t)(rlo - lo), i_offset);
+    }
+    if (rhi < hi) {
+      microBmp_raRead(ra->fd, out + (rhi - lo), (uint32_t)(hi - rhi), (uint32_t)rhi);
+    }
+  }
+}
+
+void microBmp_readAheadGetStats(const microBmp_ReadAhead* i_ra, microBmp_ReadAheadStats* o_stats)
+{
+  o_stats->blocksRead  = atomic_load(&((microBmp_ReadAhead*)i_ra)->blocksRead);
+  o_stats->stalls      = i_ra->stalls;
+  o_stats->directReads = i_ra->directReads;
+}
+
+void microBmp_readAheadClose(microBmp_ReadAhead* io_ra)
+{
+  if (!io_ra) {
+    return;
+  }
+  if (io_ra->started) {
+    atomic_store(&io_ra->stop, 1);
+    atomic_store(&io_ra->tail, io_ra->numBlocks);   // changes the futex word, so a waiting thread can not miss the stop
+    microBmp_raWake(&io_ra->tail);
+    pthread_join(io_ra->thread, NULL);
+  }
+  close(io_ra->fd);
+  free(io_ra->ring);
+  free(io_ra);
+}
+
+#endif
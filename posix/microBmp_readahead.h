@@ -0,0 +1,70 @@
+/**
+ * optional read-ahead source for Linux hosts.
+ * A producer thread preads the image data of a bmp file block by block in the order microBmp_getNextRow walks it
+ * (from the end of the file backwards, forwards for top down images and MBMP_INIT_FILE_ORDER) into a lock-free
+ * single-producer/single-consumer ring.
+ * microBmp_readAheadLoad serves the loads of the decoder from that ring, so the decoder only waits
+ * if the thread could not keep up (counted as stall).
+ *
+ * Unlike the core library this module allocates memory (the ring) and uses pthreads.
+ *
+ * usage:
+ *   microBmp_ReadAhead* ra = microBmp_readAheadOpen("img.bmp", NULL);
+ *   microBmp_init(&bmp, buf, sizeof(buf), microBmp_readAheadLoad, ra);
+ *   microBmp_readAheadStart(ra, &bmp);
+ *   while ((row = microBmp_getNextRow(&bmp))) { ... }
+ *   microBmp_readAheadClose(ra);
+ */
+
+#ifndef BMP_IMAGE_READAHEAD_HEADER
+#define BMP_IMAGE_READAHEAD_HEADER
+
+#include "../microBmp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct microBmp_ReadAhead microBmp_ReadAhead;
+
+typedef struct {
+  uint32_t blockSize;        /**< bytes read by the thread at once (0 - 64KiB) */
+  uint16_t depth;            /**< number of blocks in the ring (0 - 8) */
+} microBmp_ReadAheadConfig;
+
+typedef struct {
+  uint32_t blocksRead;       /**< blocks read by the thread */
+  uint32_t stalls;           /**< loads that had to wait for the thread */
+  uint32_t directReads;      /**< loads outside of the read-ahead range (headers, seeks) that were read synchronously */
+} microBmp_ReadAheadStats;
+
+
+/**
+ * opens the file. The thread is not started until microBmp_readAheadStart.
+ *
+ * @param[in]  i_config   ring geometry, NULL - defaults
+ * \returns NULL if the file can not be opened or memory is missing
+ */
+microBmp_ReadAhead* microBmp_readAheadOpen(const char* i_path, const microBmp_ReadAheadConfig* i_config);
+
+/**
+ * starts reading the image data of the already initialized i_bmp ahead
+ * \returns 0 on success
+ */
+int microBmp_readAheadStart(microBmp_ReadAhead* io_ra, const microBmp_State* i_bmp);
+
+/** microBmp_loadDataFunc - io_userData has to be the microBmp_ReadAhead */
+void microBmp_readAheadLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData);
+
+void microBmp_readAheadGetStats(const microBmp_ReadAhead* i_ra, microBmp_ReadAheadStats* o_stats);
+
+/** stops the thread and closes the file */
+void microBmp_readAheadClose(microBmp_ReadAhead* io_ra);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * ready-made file sources, see microBmp_source.h
+ */
+
+#ifdef __linux__
+
+#define _GNU_SOURCE
+#include "microBmp_source.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+struct microBmp_Source {
+  int                  fd;
+  microBmp_SourceType  type;
+  uint32_t             flags;
+  uint32_t             fileSize;
+  const uint8_t*       map;                /**< MBMP_SOURCE_MMAP - the whole file */
+  uint32_t             alignment;          /**< MBMP_SOURCE_DIRECT - alignment of offsets, sizes and buffers */
+  uint8_t*             bounce;             /**< MBMP_SOURCE_DIRECT - aligned buffer for requests that are not aligned */
+  size_t               bounceSize;
+  microBmp_SourceStats stats;
+};
+
+
+/** reads n bytes at i_offset, bytes behind the end of the file are zero filled */
+static void microBmp_srcRead(microBmp_Source* io_src, uint8_t* o_buffer, uint32_t n, uint32_t i_offset)
+{
+  while (n > 0) {
+    ssize_t r = pread(io_src->fd, o_buffer, n, i_offset);
+    if ((r < 0) && (errno == EINTR)) {
+      continue;
+    }
+    if (r <= 0) {
+      memset(o_buffer, 0, n);
+      return;
+    }
+    io_src->stats.bytesRead += (uint64_t)r;
+    o_buffer += r;
+    n        -= (uint32_t)r;
+    i_offset += (uint32_t)r;
+  }
+}
+
+/**
+ * O_DIRECT read, widened to the alignment and read via the bounce buffer unless the request is aligned already.
+ * Of requests that only end unaligned (the last cache fill ends with the image data) just the last block is bounced.
+ */
+static void microBmp_srcReadDirect(microBmp_Source* io_src, uint8_t* o_buffer, uint32_t n, uint32_t i_offset)
+{
+  uint32_t a = io_src->alignment;
+  uint32_t begin, end;
+  size_t   size;
+  if (((uintptr_t)o_buffer % a == 0) && (i_offset % a == 0)) {
+    uint32_t body = n & ~(a - 1);
+    if (body > 0) {
+      microBmp_srcRead(io_src, o_buffer, body, i_offset);
+    }
+    o_buffer += body;
+    i_offset += body;
+    n        -= body;
+    if (n == 0) {
+      return;
+    }
+  }
+  begin = i_offset & ~(a - 1);
+  end   = (i_offset + n + a - 1) & ~(a - 1);
+  size  = end - begin;
+  if (size > io_src->bounceSize) {
+    void* mem;
+    if (posix_memalign(&mem, a, size) != 0) {
+      memset(o_buffer, 0, n);
+      return;
+    }
+    free(io_src->bounce);
+    io_src->bounce     = (uint8_t*)mem;
+    io_src->bounceSize = size;
+  }
+  ++io_src->stats.bounced;
+  microBmp_srcRead(io_src, io_src->bounce, (uint32_t)size, begin);
+  memcpy(o_buffer, io_src->bounce + (i_offset - begin), n);
+}
+
+
+/** reads a number from a sysfs file, 0 if it does not exist */
+static uint32_t microBmp_srcReadSysfs(const char* i_path)
+{
+  FILE*    f     = fopen(i_path, "r");
+  unsigned value = 0;
+  if (f) {
+    if (fscanf(f, "%u", &value) != 1) {
+      value = 0;
+    }
+    fclose(f);
+  }
+  return value;
+}
+
+/**
+ * alignment of offsets, sizes and buffers of O_DIRECT requests to the opened file,
+ * 0 if the file does not support O_DIRECT (although it could be opened that way)
+ */
+static uint32_t microBmp_srcDirectAlignment(int i_fd)
+{
+  struct stat st;
+  char        path[96];
+  uint32_t    a = 0;
+#ifdef STATX_DIOALIGN
+  struct statx stx;
+  if ((statx(i_fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0) && (stx.stx_mask & STATX_DIOALIGN)) {   // Linux 6.1+
+    if (stx.stx_dio_offset_align == 0) {
+      return 0;
+    }
+    return (stx.stx_dio_mem_align > stx.stx_dio_offset_align) ? stx.stx_dio_mem_align : stx.stx_dio_offset_align;
+  }
+#endif
+  // logical block size of the device (what BLKSSZGET returns, but without opening the device), partitions inherit it from the disk
+  if (fstat(i_fd, &st) == 0) {
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/queue/logical_block_size", major(st.st_dev), minor(st.st_dev));
+    a = microBmp_srcReadSysfs(path);
+    if (a == 0) {
+      snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/../queue/logical_block_size", major(st.st_dev), minor(st.st_dev));
+      a = microBmp_srcReadSysfs(path);
+    }
+  }
+  return ((a > 0) && !(a & (a - 1))) ? a : 4096;
+}
+
+
+microBmp_Source* microBmp_sourceOpen(const char* i_path, microBmp_SourceType i_type, uint32_t i_flags)
+{
+  microBmp_Source* src = (microBmp_Source*)calloc(1, sizeof(microBmp_Source));
+  struct stat      st;
+  if (!src) {
+    return NULL;
+  }
+  src->type      = i_type;
+  src->flags     = i_flags;
+  src->alignment = 1;
+  src->fd        = -1;
+  if (i_type == MBMP_SOURCE_DIRECT) {
+    src->fd = open(i_path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+    if (src->fd >= 0) {
+      src->alignment = microBmp_srcDirectAlignment(src->fd);
+      if (src->alignment == 0) {
+        close(src->fd);
+        src->fd        = -1;
+        src->alignment = 1;
+      }
+    }
+  }
+  if (src->fd < 0) {                                // not direct or O_DIRECT is not supported (e.g. tmpfs)
+    src->fd = open(i_path, O_RDONLY | O_CLOEXEC);
+  }
+  if ((src->fd < 0) || (fstat(src->fd, &st) != 0) || (st.st_size > UINT32_MAX)) {
+    microBmp_sourceClose(src);
+    return NULL;
+  }
+  src->fileSize        = (uint32_t)st.st_size;
+  src->stats.alignment = src->alignment;
+
+  if (i_type == MBMP_SOURCE_MMAP) {
+    void* map = (src->fileSize > 0) ? mmap(NULL, src->fileSize, PROT_READ, MAP_SHARED, src->fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+      microBmp_sourceClose(src);
+      return NULL;
+    }
+    src->map = (const uint8_t*)map;
+  }
+  return src;
+}
+
+/** microBmp_prefetchFunc - lets the page cache read the next block of the decoder in the background */
+static void microBmp_sourcePrefetch(uint32_t i_offset, uint32_t i_numBytes, void* io_userData)
+{
+  microBmp_Source* src = (microBmp_Source*)io_userData;
+  ++src->stats.hints;
+  (void)posix_fadvise(src->fd, i_offset, i_numBytes, POSIX_FADV_WILLNEED);
+}
+
+microBmpStatus microBmp_sourceInit(microBmp_Source* io_src, microBmp_State* o_bmp, uint8_t* io_buffer, size_t i_buffersize, uint32_t i_flags)
+{
+  microBmpStatus status = microBmp_initEx(o_bmp, io_buffer, i_buffersize, microBmp_sourceLoad, io_src, i_flags);
+  if (status != MBMP_STATUS_OK) {
+    return status;
+  }
+  if (io_src->alignment > 1) {                    // O_DIRECT - cache fills cover whole blocks of the file system
+    status = microBmp_setLoadAlignment(o_bmp, io_src->alignment);
+    if (status != MBMP_STATUS_OK) {
+      return status;
+    }
+  }
+  if (io_src->map) {
+    microBmp_setMapDataFunc(o_bmp, microBmp_sourceMap);
+  } else if ((io_src->flags & MBMP_SOURCE_ADVISE) && (io_src->alignment == 1)) {
+    if (o_bmp->topDown || o_bmp->fileOrder) {     // rows are read from the start of the file on
+      (void)posix_fadvise(io_src->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else {
+      // bottom up - the forward read-ahead of the kernel would only read rows that are decoded already
+      (void)posix_fadvise(io_src->fd, 0, 0, POSIX_FADV_RANDOM);
+      microBmp_setPrefetchFunc(o_bmp, microBmp_sourcePrefetch);
+    }
+  }
+  return MBMP_STATUS_OK;
+}
+
+void microBmp_sourceLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  microBmp_Source* src = (microBmp_Source*)io_userData;
+  uint8_t*         dst = (uint8_t*)o_buffer;
+  ++src->stats.loads;
+  if (src->map) {
+    uint32_t avail = (i_offset < src->fileSize) ? src->fileSize - i_offset : 0;
+    uint32_t n     = (i_numBytes < avail) ? i_numBytes : avail;
+    memcpy(dst, src->map + i_offset, n);
+    memset(dst + n, 0, i_numBytes - n);
+    return;
+  }
+  if (src->alignment > 1) {
+    microBmp_srcReadDirect(src, dst, i_numBytes, i_offset);
+  } else {
+    microBmp_srcRead(src, dst, i_numBytes, i_offset);
+  }
+}
+
+const void* microBmp_sourceMap(uint32_t i_offset, uint32_t i_numBytes, void* io_userData)
+{
+  microBmp_Source* src = (microBmp_Source*)io_userData;
+  if (!src->map || (i_offset > src->fileSize) || (i_numBytes > src->fileSize - i_offset)) {
+    return NULL;
+  }
+  if (src->flags & MBMP_SOURCE_ADVISE) {
+    uintptr_t page  = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)(src->map + i_offset)) & ~(page - 1);
+    (void)madvise((void*)begin, (uintptr_t)(src->map + i_offset + i_numBytes) - begin, MADV_WILLNEED);
+  }
+  ++src->stats.maps;
+  return src->map + i_offset;
+}
+
+void microBmp_sourceGetStats(const microBmp_Source* i_src, microBmp_SourceStats* o_stats)
+{
+  *o_stats = i_src->stats;
+}
+
+void microBmp_sourceClose(microBmp_Source* io_src)
+{
+  if (!io_src) {
+    return;
+  }
+  if (io_src->map) {
+    munmap((void*)io_src->map, io_src->fileSize);
+  }
+  if (io_src->fd >= 0) {
+    close(io_src->fd);
+  }
+  free(io_src->bounce);
+  free(io_src);
+}
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * optional ready-made file sources for Linux hosts (instead of writing a loadDataFunc for every project).
+ *
+ *  - MBMP_SOURCE_PREAD   pread into the cache of the decoder
+ *  - MBMP_SOURCE_MMAP    maps the file, rows are used in place via microBmp_setMapDataFunc (zero copy)
+ *  - MBMP_SOURCE_DIRECT  O_DIRECT reads that bypass the page cache. The alignment comes from statx (STATX_DIOALIGN)
+ *                        or the logical block size of the device. The decoder aligns its cache fills and cache blocks to it
+ *                        (microBmp_setLoadAlignment), so they are read directly (except the end of the last one, that
+ *                        ends with the image data), other requests (headers, rows of a column window) are widened and
+ *                        read via an aligned bounce buffer
+ *
+ * MBMP_SOURCE_ADVISE adds hints that match the order the decoder reads the file in (posix_fadvise):
+ *  - bottom up images (the last rows of the file are read first) - the kernel read-ahead, that only works forwards,
+ *    is switched off (POSIX_FADV_RANDOM) and the blocks announced by the decoder (microBmp_setPrefetchFunc) are requested instead
+ *  - top down images and MBMP_INIT_FILE_ORDER - forward reads, the kernel read-ahead is enlarged (POSIX_FADV_SEQUENTIAL)
+ * Mapped ranges are requested at once (madvise).
+ *
+ * Unlike the core library this module allocates memory.
+ *
+ * usage:
+ *   microBmp_Source* src = microBmp_sourceOpen("img.bmp", MBMP_SOURCE_MMAP, MBMP_SOURCE_ADVISE);
+ *   microBmp_sourceInit(src, &bmp, buf, sizeof(buf), MBMP_INIT_DEFAULT);
+ *   while ((row = microBmp_getNextRow(&bmp))) { ... }
+ *   microBmp_sourceClose(src);
+ */
+
+#ifndef BMP_IMAGE_SOURCE_HEADER
+#define BMP_IMAGE_SOURCE_HEADER
+
+#include "../microBmp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef enum {
+  MBMP_SOURCE_PREAD = 0,
+  MBMP_SOURCE_MMAP,
+  MBMP_SOURCE_DIRECT
+} microBmp_SourceType;
+
+/** options for microBmp_sourceOpen */
+typedef enum {
+  MBMP_SOURCE_DEFAULT = 0,
+  MBMP_SOURCE_ADVISE  = 1 << 0     /**< access pattern hints for the page cache (see above) */
+} microBmp_SourceFlags;
+
+typedef struct microBmp_Source microBmp_Source;
+
+typedef struct {
+  uint32_t loads;            /**< calls of microBmp_sourceLoad */
+  uint32_t maps;             /**< calls of microBmp_sourceMap that returned the rows in place */
+  uint32_t bounced;          /**< O_DIRECT loads that needed the bounce buffer (not aligned, or just for their unaligned end) */
+  uint32_t hints;            /**< blocks announced by the decoder that were passed on to the page cache */
+  uint64_t bytesRead;        /**< bytes read from the file (including the alignment of O_DIRECT) */
+  uint32_t alignment;        /**< alignment of O_DIRECT requests, 1 - O_DIRECT is not supported by the file system (buffered reads) */
+} microBmp_SourceStats;
+
+
+/**
+ * opens the file
+ * \returns NULL if the file can not be opened (or mapped)
+ */
+microBmp_Source* microBmp_sourceOpen(const char* i_path, microBmp_SourceType i_type, uint32_t i_flags);
+
+/**
+ * microBmp_initEx with the source as loadDataFunc, also sets the mapDataFunc of mapped sources, the load alignment
+ * of O_DIRECT sources (microBmp_setLoadAlignment) and starts the hints if requested.
+ */
+microBmpStatus microBmp_sourceInit(microBmp_Source* io_src, microBmp_State* o_bmp, uint8_t* io_buffer, size_t i_buffersize, uint32_t i_flags);
+
+/** microBmp_loadDataFunc - io_userData has to be the microBmp_Source */
+void microBmp_sourceLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData);
+
+/** microBmp_mapDataFunc - returns NULL for sources that are not mapped */
+const void* microBmp_sourceMap(uint32_t i_offset, uint32_t i_numBytes, void* io_userData);
+
+void microBmp_sourceGetStats(const microBmp_Source* i_src, microBmp_SourceStats* o_stats);
+
+void microBmp_sourceClose(microBmp_Source* io_src);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
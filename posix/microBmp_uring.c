@@ -0,0 +1,376 @@
+/**
+ * io_uring batch front end, see microBmp_uring.h
+ *
+ * Every queue entry (microBmp_BatchFile) works on one file and has at most one request in the ring at a time:
+ *   open -> read head -> microBmp_initEx (served from the head) -> block loads started by the microBmp_State
+ * After a completion the rows of the file are passed on until the state reports rowNotReady again (the load of the
+ * next block is queued then) or the image is finished and the entry continues with the next file.
+ */
+
+#ifdef __linux__
+
+#define _GNU_SOURCE
+#include "microBmp_uring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum {
+  MBMP_BATCH_IDLE = 0,
+  MBMP_BATCH_OPEN,
+  MBMP_BATCH_HEAD,
+  MBMP_BATCH_LOAD
+};
+
+typedef struct microBmp_Batch microBmp_Batch;
+
+typedef struct {
+  microBmp_Batch* batch;
+  microBmp_State  bmp;
+  const char*     path;
+  int             fd;
+  int             phase;
+  uint8_t*        head;
+  uint32_t        headLen;             /**< bytes of the file that are in head */
+  uint8_t*        buffer;
+  uint8_t*        loadBuf;             /**< destination of the running block load */
+  uint32_t        loadBytes;
+} microBmp_BatchFile;
+
+struct microBmp_Batch {
+  int                      ringFd;
+  void*                    sqMap;
+  size_t                   sqMapSize;
+  void*                    cqMap;
+  size_t                   cqMapSize;
+  struct io_uring_sqe*     sqes;
+  size_t                   sqesSize;
+  unsigned*                sqTail;
+  unsigned                 sqMask;
+  unsigned*                sqArray;
+  unsigned*                cqHead;
+  unsigned*                cqTail;
+  unsigned                 cqMask;
+  struct io_uring_cqe*     cqes;
+  unsigned                 toSubmit;
+  unsigned                 inFlight;
+  microBmp_BatchConfig     config;
+  microBmp_BatchCallbacks  callbacks;
+  microBmp_BatchStats      stats;
+  const char* const*       paths;
+  uint32_t                 numPaths;
+  uint32_t                 nextPath;
+  uint32_t                 active;
+};
+
+
+static int microBmp_batchSetup(microBmp_Batch* io_b)
+{
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  io_b->ringFd = (int)syscall(__NR_io_uring_setup, io_b->config.queueDepth, &p);
+  if (io_b->ringFd < 0) {
+    return -1;
+  }
+  io_b->sqMapSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  io_b->cqMapSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (io_b->cqMapSize > io_b->sqMapSize) {
+      io_b->sqMapSize = io_b->cqMapSize;
+    }
+    io_b->cqMapSize = 0;
+  }
+  io_b->sqMap = mmap(NULL, io_b->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_b->ringFd, IORING_OFF_SQ_RING);
+  if (io_b->sqMap == MAP_FAILED) {
+    io_b->sqMap = NULL;
+    return -1;
+  }
+  io_b->cqMap = io_b->sqMap;
+  if (io_b->cqMapSize) {
+    io_b->cqMap = mmap(NULL, io_b->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_b->ringFd, IORING_OFF_CQ_RING);
+    if (io_b->cqMap == MAP_FAILED) {
+      io_b->cqMap = NULL;
+      return -1;
+    }
+  }
+  io_b->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+  io_b->sqes = (struct io_uring_sqe*)mmap(NULL, io_b->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_b->ringFd, IORING_OFF_SQES);
+  if (io_b->sqes == MAP_FAILED) {
+    io_b->sqes = NULL;
+    return -1;
+  }
+  io_b->sqTail  = (unsigned*)((uint8_t*)io_b->sqMap + p.sq_off.tail);
+  io_b->sqMask  = *(unsigned*)((uint8_t*)io_b->sqMap + p.sq_off.ring_mask);
+  io_b->sqArray = (unsigned*)((uint8_t*)io_b->sqMap + p.sq_off.array);
+  io_b->cqHead  = (unsigned*)((uint8_t*)io_b->cqMap + p.cq_off.head);
+  io_b->cqTail  = (unsigned*)((uint8_t*)io_b->cqMap + p.cq_off.tail);
+  io_b->cqMask  = *(unsigned*)((uint8_t*)io_b->cqMap + p.cq_off.ring_mask);
+  io_b->cqes    = (struct io_uring_cqe*)((uint8_t*)io_b->cqMap + p.cq_off.cqes);
+  return 0;
+}
+
+static void microBmp_batchTeardown(microBmp_Batch* io_b)
+{
+  if (io_b->sqes) {
+    munmap(io_b->sqes, io_b->sqesSize);
+  }
+  if (io_b->cqMap && (io_b->cqMap != io_b->sqMap)) {
+    munmap(io_b->cqMap, io_b->cqMapSize);
+  }
+  if (io_b->sqMap) {
+    munmap(io_b->sqMap, io_b->sqMapSize);
+  }
+  if (io_b->ringFd >= 0) {
+    close(io_b->ringFd);
+  }
+}
+
+/**
+ * returns a cleared submission entry for io_file. Never runs out of entries, since every file has at most
+ * one request in the ring and the ring has queueDepth entries.
+ */
+static struct io_uring_sqe* microBmp_batchQueue(microBmp_BatchFile* io_file, uint8_t i_opcode)
+{
+  microBmp_Batch*      b    = io_file->batch;
+  unsigned             tail = *b->sqTail;
+  unsigned             idx  = tail & b->sqMask;
+  struct io_uring_sqe* sqe  = &b->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode    = i_opcode;
+  sqe->user_data = (uint64_t)(uintptr_t)io_file;
+  b->sqArray[idx] = idx;
+  __atomic_store_n(b->sqTail, tail + 1, __ATOMIC_RELEASE);
+  ++b->toSubmit;
+  return sqe;
+}
+
+static void microBmp_batchQueueRead(microBmp_BatchFile* io_file, void* o_buffer, uint32_t i_numBytes, uint64_t i_offset)
+{
+  struct io_uring_sqe* sqe = microBmp_batchQueue(io_file, IORING_OP_READ);
+  sqe->fd   = io_file->fd;
+  sqe->addr = (uint64_t)(uintptr_t)o_buffer;
+  sqe->len  = i_numBytes;
+  sqe->off  = i_offset;
+  ++io_file->batch->stats.reads;
+}
+
+/** microBmp_loadDataFunc of the files - serves the loads of microBmp_initEx from the head */
+static void microBmp_batchLoadHead(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  microBmp_BatchFile* f = (microBmp_BatchFile*)io_userData;
+  ssize_t             r;
+  if ((i_offset <= f->headLen) && (i_numBytes <= f->headLen - i_offset)) {
+    memcpy(o_buffer, f->head + i_offset, i_numBytes);
+    return;
+  }
+  ++f->batch->stats.syncReads;
+  r = pread(f->fd, o_buffer, i_numBytes, i_offset);
+  if (r < 0) {
+    r = 0;
+  }
+  memset((uint8_t*)o_buffer + r, 0, i_numBytes - (size_t)r);
+}
+
+/** microBmp_startLoadFunc of the files - queues the read of a cache block */
+static void microBmp_batchStartLoad(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  microBmp_BatchFile* f   = (microBmp_BatchFile*)io_userData;
+  uint8_t*            dst = (uint8_t*)o_buffer;
+  f->loadBuf   = dst;
+  f->loadBytes = i_numBytes;
+  f->phase     = MBMP_BATCH_LOAD;
+  microBmp_batchQueueRead(f, dst, i_numBytes, i_offset);
+}
+
+static void microBmp_batchNextFile(microBmp_BatchFile* io_file);
+
+static void microBmp_batchFinish(microBmp_BatchFile* io_file, int i_status)
+{
+  microBmp_Batch* b = io_file->batch;
+  if (io_file->fd >= 0) {
+    close(io_file->fd);
+    io_file->fd = -1;
+  }
+  if (i_status == MBMP_STATUS_OK) {
+    ++b->stats.filesDone;
+  } else {
+    ++b->stats.filesFailed;
+  }
+  if (b->callbacks.done) {
+    b->callbacks.done(&io_file->bmp, io_file->path, i_status, b->callbacks.userData);
+  }
+  io_file->phase = MBMP_BATCH_IDLE;
+  --b->active;
+  microBmp_batchNextFile(io_file);
+}
+
+/** passes all available rows on, until the next block has to be loaded or the image is finished */
+static void microBmp_batchPump(microBmp_BatchFile* io_file)
+{
+  microBmp_Batch* b = io_file->batch;
+  const uint8_t*  row;
+  while ((row = microBmp_getNextRow(&io_file->bmp)) != NULL) {
+    if (b->callbacks.row) {
+      b->callbacks.row(&io_file->bmp, row, io_file->bmp.rowY, b->callbacks.userData);
+    }
+  }
+  if (!io_file->bmp.rowNotReady) {
+    microBmp_batchFinish(io_file, MBMP_STATUS_OK);
+  }
+}
+
+static void microBmp_batchNextFile(microBmp_BatchFile* io_file)
+{
+  microBmp_Batch*      b = io_file->batch;
+  struct io_uring_sqe* sqe;
+  if (b->nextPath >= b->numPaths) {
+    return;
+  }
+  io_file->path  = b->paths[b->nextPath++];
+  io_file->fd    = -1;
+  io_file->phase = MBMP_BATCH_OPEN;
+  ++b->active;
+  sqe = microBmp_batchQueue(io_file, IORING_OP_OPENAT);
+  sqe->fd         = AT_FDCWD;
+  sqe->addr       = (uint64_t)(uintptr_t)io_file->path;
+  sqe->open_flags = O_RDONLY | O_CLOEXEC;
+}
+
+static void microBmp_batchComplete(microBmp_BatchFile* io_file, int i_res)
+{
+  microBmp_Batch* b = io_file->batch;
+  int             status;
+  if (i_res < 0) {
+    microBmp_batchFinish(io_file, i_res);
+    return;
+  }
+  switch (io_file->phase) {
+    case MBMP_BATCH_OPEN:
+      io_file->fd    = i_res;
+      io_file->phase = MBMP_BATCH_HEAD;
+      microBmp_batchQueueRead(io_file, io_file->head, b->config.headBytes, 0);
+      break;
+
+    case MBMP_BATCH_HEAD:
+      io_file->headLen = (uint32_t)i_res;
+      status = microBmp_initEx(&io_file->bmp, io_file->buffer, b->config.bufferSize, microBmp_batchLoadHead, io_file, b->config.initFlags);
+      if (status == MBMP_STATUS_OK) {
+        status = microBmp_setAsyncLoad(&io_file->bmp, microBmp_batchStartLoad);
+      }
+      if (status != MBMP_STATUS_OK) {
+        microBmp_batchFinish(io_file, status);
+        break;
+      }
+      microBmp_batchPump(io_file);
+      break;
+
+    case MBMP_BATCH_LOAD:
+      if ((uint32_t)i_res < io_file->loadBytes) {          // behind the end of the file
+        memset(io_file->loadBuf + i_res, 0, io_file->loadBytes - (uint32_t)i_res);
+      }
+      microBmp_loadComplete(&io_file->bmp);
+      microBmp_batchPump(io_file);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/** submits the queued requests, waits for at least one completion and handles all available completions */
+static int microBmp_batchStep(microBmp_Batch* io_b)
+{
+  unsigned head;
+  int      ret;
+  io_b->inFlight += io_b->toSubmit;
+  if (io_b->inFlight > io_b->stats.maxInFlight) {
+    io_b->stats.maxInFlight = io_b->inFlight;
+  }
+  do {
+    ret = (int)syscall(__NR_io_uring_enter, io_b->ringFd, io_b->toSubmit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+  } while ((ret < 0) && (errno == EINTR));
+  if (ret < 0) {
+    return -1;
+  }
+  io_b->toSubmit -= (unsigned)ret;
+  io_b->inFlight -= io_b->toSubmit;               // not consumed by the kernel, submitted again with the next step
+
+  head = *io_b->cqHead;
+  while (head != __atomic_load_n(io_b->cqTail, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe* cqe = &io_b->cqes[head & io_b->cqMask];
+    microBmp_BatchFile*  f   = (microBmp_BatchFile*)(uintptr_t)cqe->user_data;
+    int                  res = cqe->res;
+    ++head;
+    __atomic_store_n(io_b->cqHead, head, __ATOMIC_RELEASE);
+    --io_b->inFlight;
+    microBmp_batchComplete(f, res);
+  }
+  return 0;
+}
+
+int microBmp_batchDecode(const char* const* i_paths, uint32_t i_numPaths, const microBmp_BatchConfig* i_config,
+                         const microBmp_BatchCallbacks* i_callbacks, microBmp_BatchStats* o_stats)
+{
+  microBmp_Batch       b;
+  microBmp_BatchFile*  files;
+  uint8_t*             mem;
+  uint32_t             i;
+  int                  ret = 0;
+
+  memset(&b, 0, sizeof(b));
+  b.ringFd = -1;
+  if (i_config) {
+    b.config = *i_config;
+  }
+  if (i_callbacks) {
+    b.callbacks = *i_callbacks;
+  }
+  b.config.queueDepth = b.config.queueDepth ? b.config.queueDepth : 32;
+  b.config.headBytes  = b.config.headBytes  ? b.config.headBytes  : 4 * 1024;
+  b.config.bufferSize = b.config.bufferSize ? b.config.bufferSize : 64 * 1024;
+  if (b.config.queueDepth > i_numPaths) {
+    b.config.queueDepth = (uint16_t)(i_numPaths ? i_numPaths : 1);
+  }
+  b.paths    = i_paths;
+  b.numPaths = i_numPaths;
+
+  files = (microBmp_BatchFile*)calloc(b.config.queueDepth, sizeof(microBmp_BatchFile));
+  mem   = (uint8_t*)malloc((size_t)b.config.queueDepth * (b.config.headBytes + b.config.bufferSize));
+  if (!files || !mem || (microBmp_batchSetup(&b) != 0)) {
+    ret = -1;
+  } else {
+    for (i = 0; i < b.config.queueDepth; ++i) {
+      files[i].batch  = &b;
+      files[i].fd     = -1;
+      files[i].head   = mem + (size_t)i * (b.config.headBytes + b.config.bufferSize);
+      files[i].buffer = files[i].head + b.config.headBytes;
+      microBmp_batchNextFile(&files[i]);
+    }
+    while (b.active > 0) {
+      if (microBmp_batchStep(&b) != 0) {
+        ret = -1;
+        break;
+      }
+    }
+    for (i = 0; i < b.config.queueDepth; ++i) {    // only left open if the ring failed
+      if (files[i].fd >= 0) {
+        close(files[i].fd);
+      }
+    }
+  }
+  microBmp_batchTeardown(&b);
+  free(mem);
+  free(files);
+  if (o_stats) {
+    *o_stats = b.stats;
+  }
+  return ret;
+}
+
+#endif
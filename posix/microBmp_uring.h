@@ -0,0 +1,78 @@
+/**
+ * optional io_uring batch front end for Linux hosts.
+ * Decodes many bmp files at once: the files are opened and their headers are read through one io_uring,
+ * then every file gets its own microBmp_State in asynchronous mode (microBmp_setAsyncLoad) whose block loads
+ * are queued to the same ring. The rows of a file are passed to a callback as soon as its data arrives,
+ * so the kernel can overlap the reads of up to queueDepth files instead of waiting for one read at a time.
+ *
+ * Unlike the core library this module allocates memory (one decode buffer per queue entry).
+ * No liburing is needed, the ring is set up with the raw system calls (kernel 5.6 or newer).
+ *
+ * usage:
+ *   static void onRow(microBmp_State* bmp, const uint8_t* row, uint16_t y, void* user) { ... }
+ *   static void onDone(microBmp_State* bmp, const char* path, int status, void* user) { ... }
+ *   microBmp_BatchCallbacks cb = { onRow, onDone, NULL };
+ *   microBmp_batchDecode(paths, numPaths, NULL, &cb, NULL);
+ */
+
+#ifndef BMP_IMAGE_URING_HEADER
+#define BMP_IMAGE_URING_HEADER
+
+#include "../microBmp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct {
+  uint16_t queueDepth;       /**< files decoded at the same time = maximum reads in flight (0 - 32) */
+  uint32_t headBytes;        /**< bytes read from the start of a file with the open, should cover header and palette (0 - 4KiB) */
+  uint32_t bufferSize;       /**< microBmp buffer of each file (0 - 64KiB) */
+  uint32_t initFlags;        /**< flags for microBmp_initEx */
+} microBmp_BatchConfig;
+
+typedef struct {
+  uint32_t filesDone;        /**< files that were decoded completely */
+  uint32_t filesFailed;      /**< files that could not be opened, read or initialized */
+  uint32_t reads;            /**< reads queued to the ring (header and cache blocks) */
+  uint32_t syncReads;        /**< header loads that were not covered by headBytes and were read synchronously */
+  uint32_t maxInFlight;      /**< highest number of requests the kernel worked on at the same time */
+} microBmp_BatchStats;
+
+/**
+ * called for each row of a file in the order of microBmp_getNextRow (file order with MBMP_INIT_FILE_ORDER in initFlags),
+ * i_y is the image row (0 - top). The row is valid until the callback returns.
+ */
+typedef void (*microBmp_batchRowFunc)(microBmp_State* i_bmp, const uint8_t* i_row, uint16_t i_y, void* io_userData);
+
+/**
+ * called when a file is finished.
+ * i_status is the microBmpStatus of microBmp_initEx (MBMP_STATUS_OK - all rows were passed to the row callback)
+ * or a negative errno if the file could not be opened or read.
+ * i_bmp is only initialized for MBMP_STATUS_OK, it is reused for the next file after the callback.
+ */
+typedef void (*microBmp_batchDoneFunc)(microBmp_State* i_bmp, const char* i_path, int i_status, void* io_userData);
+
+typedef struct {
+  microBmp_batchRowFunc  row;        /**< optional */
+  microBmp_batchDoneFunc done;       /**< optional */
+  void*                  userData;
+} microBmp_BatchCallbacks;
+
+/**
+ * decodes all files, returns when the last one is finished.
+ *
+ * @param[in]  i_config   queue depth and buffer sizes, NULL - defaults
+ * @param[out] o_stats    optional
+ * \returns 0 on success, -1 if the ring or the buffers can not be created
+ */
+int microBmp_batchDecode(const char* const* i_paths, uint32_t i_numPaths, const microBmp_BatchConfig* i_config,
+                         const microBmp_BatchCallbacks* i_callbacks, microBmp_BatchStats* o_stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * checks the row converters that are selected for the target (NEON, SSE2/SSSE3/AVX2 or SWAR) and the portable
+ * scalar ones (MBMP_INIT_NO_SIMD) against reference pixels that are computed independently of the library
+ * (palette entries, 16bit channels expanded to 8bit by bit replication, RGB565 from the 8bit channels).
+ * Synthetic images of every source format with random pixels and widths 1..MAX_WIDTH are converted to RGB and
+ * RGB565 for many column ranges, with and without palette lookup tables. Pixels outside of the range must stay untouched.
+ * Prints the number of mismatches and returns non zero if there are any.
+ *
+ * build and run on the host (x86 converters, or SWAR with -DMBMP_SWAR):
+ *   gcc -O2 -o test_converters test_converters.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ *   ./test_converters
+ *
+ * NEON converters under qemu-user (packages gcc-aarch64-linux-gnu / gcc-arm-linux-gnueabihf and qemu-user):
+ *   aarch64-linux-gnu-gcc -O2 -static -o test_converters_a64 test_converters.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ *   qemu-aarch64 ./test_converters_a64
+ *   arm-linux-gnueabihf-gcc -O2 -static -mfpu=neon -mfloat-abi=hard -o test_converters_a32 test_converters.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ *   qemu-arm ./test_converters_a32
+ * (without -static: qemu-aarch64 -L /usr/aarch64-linux-gnu resp. qemu-arm -L /usr/arm-linux-gnueabihf)
+ * SWAR converters of Cortex-M like cores: the armhf build without -mfpu=neon (e.g. -mfpu=vfpv3-d16).
+ */
+
+#include "../microBmp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WIDTH  80
+#define HEIGHT     3
+
+typedef struct {
+  const char* name;
+  uint16_t    bitsPerPixel;
+  uint32_t    compression;
+  uint32_t    masks[3];
+  uint32_t    colors;
+} Format;
+
+static const Format s_formats[] = {
+  { "index1",     1,  0, { 0, 0, 0 },                        2 },
+  { "index4",     4,  0, { 0, 0, 0 },                       16 },
+  { "index4/7",   4,  0, { 0, 0, 0 },                        7 },
+  { "index8",     8,  0, { 0, 0, 0 },                      256 },
+  { "index8/100", 8,  0, { 0, 0, 0 },                      100 },
+  { "rgb555",    16,  0, { 0, 0, 0 },                        0 },
+  { "rgb565",    16,  3, { 0xF800, 0x07E0, 0x001F },         0 },
+  { "rgb555 c3", 16,  3, { 0x7C00, 0x03E0, 0x001F },         0 },
+  { "rgb444",    16,  3, { 0x0F00, 0x00F0, 0x000F },         0 },
+  { "bgr24",     24,  0, { 0, 0, 0 },                        0 },
+  { "bgrx32",    32,  0, { 0, 0, 0 },                        0 },
+  { "bgrx32 c3", 32,  3, { 0xFF0000, 0x00FF00, 0x0000FF },   0 },
+};
+
+static uint8_t  s_file[14 + 40 + 12 + 256 * 4 + HEIGHT * (MAX_WIDTH * 4 + 4)];
+static uint8_t  s_buffer[2][8192];
+static uint8_t  s_rgb[2][MAX_WIDTH * 3 + 3];      // one pixel more to detect writes behind the range
+static uint16_t s_565[2][MAX_WIDTH + 1];
+static uint8_t  s_refRgb[MAX_WIDTH * 3 + 3];
+static uint16_t s_ref565[MAX_WIDTH + 1];
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+/** writes a bmp with random pixels (and palette) into s_file */
+static void makeImage(const Format* i_fmt, uint16_t i_width)
+{
+  uint32_t rowBytes = ((uint32_t)i_width * i_fmt->bitsPerPixel + 31) / 32 * 4;
+  uint32_t header   = 14 + 40 + ((i_fmt->compression == 3) ? 12 : 0);
+  uint32_t offset   = header + i_fmt->colors * 4;
+  uint32_t i;
+  memset(s_file, 0, sizeof(s_file));
+  s_file[0] = 'B';
+  s_file[1] = 'M';
+  put32(s_file +  2, offset + rowBytes * HEIGHT);
+  put32(s_file + 10, offset);
+  put32(s_file + 14, 40);
+  put32(s_file + 18, i_width);
+  put32(s_file + 22, HEIGHT);
+  put16(s_file + 26, 1);
+  put16(s_file + 28, i_fmt->bitsPerPixel);
+  put32(s_file + 30, i_fmt->compression);
+  put32(s_file + 46, i_fmt->colors);
+  if (i_fmt->compression == 3) {
+    put32(s_file + 54, i_fmt->masks[0]);
+    put32(s_file + 58, i_fmt->masks[1]);
+    put32(s_file + 62, i_fmt->masks[2]);
+  }
+  for (i = header; i < offset + rowBytes * HEIGHT; ++i) {
+    s_file[i] = (uint8_t)rand();
+  }
+  if (i_fmt->colors) {    // indices beyond a short palette are undefined, keep them below i_fmt->colors
+    uint32_t pixelsPerByte = 8u / i_fmt->bitsPerPixel;
+    uint32_t maxIndex      = (1u << i_fmt->bitsPerPixel) - 1;
+    for (i = offset; i < offset + rowBytes * HEIGHT; ++i) {
+      uint8_t  b = 0;
+      uint32_t p;
+      for (p = 0; p < pixelsPerByte; ++p) {
+        b = (uint8_t)((b << i_fmt->bitsPerPixel) | ((uint32_t)rand() % i_fmt->colors & maxIndex));
+      }
+      s_file[i] = b;
+    }
+  }
+}
+
+/** expands the channel of a 16bit pixel selected by i_mask to 8bit by replicating its bits (8 most significant ones if wider) */
+static uint8_t refChannel(uint32_t i_pixel, uint32_t i_mask)
+{
+  uint32_t v    = 0;
+  int      bits = 0;
+  int      k;
+  if (!i_mask) {
+    return 0;
+  }
+  while (!(i_mask & 1)) {
+    i_mask  >>= 1;
+    i_pixel >>= 1;
+  }
+  for (; i_mask & 1; i_mask >>= 1) {
+    ++bits;
+  }
+  v = i_pixel & ((1u << bits) - 1);
+  if (bits > 8) {
+    v   >>= bits - 8;
+    bits  = 8;
+  }
+  for (k = 0; k < 8; k += bits) {
+    v = (v << bits) | (v & ((1u << bits) - 1));
+  }
+  return (uint8_t)(v >> (k - 8 + bits));
+}
+
+/** reference pixels [x1, x2[ of image row y (0 - top) of the image in s_file, the other pixels are set to 0xCD like the outputs */
+static void refRow(const Format* i_fmt, uint16_t i_width, uint16_t y, uint16_t x1, uint16_t x2)
+{
+  uint32_t       rowBytes = ((uint32_t)i_width * i_fmt->bitsPerPixel + 31) / 32 * 4;
+  uint32_t       header   = 14 + 40 + ((i_fmt->compression == 3) ? 12 : 0);
+  const uint8_t* palette  = s_file + header;
+  const uint8_t* row      = palette + i_fmt->colors * 4 + (uint32_t)(HEIGHT - 1 - y) * rowBytes;
+  uint16_t       x;
+  memset(s_refRgb, 0xCD, sizeof(s_refRgb));
+  memset(s_ref565, 0xCD, sizeof(s_ref565));
+  for (x = x1; x < x2; ++x) {
+    uint8_t r, g, b;
+    if (i_fmt->colors) {
+      uint32_t bit   = (uint32_t)x * i_fmt->bitsPerPixel;
+      uint32_t index = (row[bit / 8] >> (8 - i_fmt->bitsPerPixel - bit % 8)) & ((1u << i_fmt->bitsPerPixel) - 1);
+      b = palette[index * 4];
+      g = palette[index * 4 + 1];
+      r = palette[index * 4 + 2];
+    } else if (i_fmt->bitsPerPixel == 16) {
+      uint32_t c16 = (uint32_t)row[x * 2] | ((uint32_t)row[x * 2 + 1] << 8);
+      int      c3  = (i_fmt->compression == 3);
+      r = refChannel(c16, c3 ? i_fmt->masks[0] : 0x7C00);
+      g = refChannel(c16, c3 ? i_fmt->masks[1] : 0x03E0);
+      b = refChannel(c16, c3 ? i_fmt->masks[2] : 0x001F);
+    } else {
+      const uint8_t* p = row + (uint32_t)x * (i_fmt->bitsPerPixel / 8);
+      b = p[0];
+      g = p[1];
+      r = p[2];
+    }
+    s_refRgb[(x - x1) * 3]     = r;
+    s_refRgb[(x - x1) * 3 + 1] = g;
+    s_refRgb[(x - x1) * 3 + 2] = b;
+    s_ref565[x - x1] = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  }
+}
+
+static void readData(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  (void)io_userData;
+  memset(o_buffer, 0, i_numBytes);
+  if (i_offset < sizeof(s_file)) {
+    memcpy(o_buffer, s_file + i_offset, (i_numBytes < sizeof(s_file) - i_offset) ? i_numBytes : sizeof(s_file) - i_offset);
+  }
+}
+
+/**
+ * compares all rows of the image in s_file for the column range [x1, x2[ with the reference,
+ * returns the number of mismatching rows
+ */
+static int compareRange(microBmp_State* io_bmp, const Format* i_fmt, uint16_t x1, uint16_t x2)
+{
+  int      fails = 0;
+  uint16_t y;
+  for (y = 0; y < HEIGHT; ++y) {
+    int k;
+    refRow(i_fmt, io_bmp[0].imageWidth, y, x1, x2);
+    for (k = 0; k < 2; ++k) {
+      if (!microBmp_getRow(&io_bmp[k], y)) {
+        return 1;
+      }
+      memset(s_rgb[k], 0xCD, sizeof(s_rgb[k]));
+      memset(s_565[k], 0xCD, sizeof(s_565[k]));
+      microBmp_convertRowToRGB(&io_bmp[k], s_rgb[k], x1, x2);
+      microBmp_convertRowTo565(&io_bmp[k], s_565[k], x1, x2);
+    }
+    if (    memcmp(s_rgb[0], s_refRgb, sizeof(s_refRgb)) || memcmp(s_565[0], s_ref565, sizeof(s_ref565))
+         || memcmp(s_rgb[1], s_refRgb, sizeof(s_refRgb)) || memcmp(s_565[1], s_ref565, sizeof(s_ref565))) {
+      ++fails;
+    }
+  }
+  return fails;
+}
+
+int main(void)
+{
+  static const uint32_t lutFlags[] = { 0, MBMP_INIT_PALETTE_LUT_RGB | MBMP_INIT_PALETTE_LUT_565 };
+  int    fails  = 0;
+  int    ranges = 0;
+  size_t f, l;
+  srand(1);
+  for (f = 0; f < sizeof(s_formats) / sizeof(s_formats[0]); ++f) {
+    for (l = 0; l < sizeof(lutFlags) / sizeof(lutFlags[0]); ++l) {
+      uint16_t width;
+      int      formatFails = 0;
+      for (width = 1; width <= MAX_WIDTH; ++width) {
+        microBmp_State bmp[2];
+        uint16_t       x1;
+        makeImage(&s_formats[f], width);
+        if (    (microBmp_initEx(&bmp[0], s_buffer[0], sizeof(s_buffer[0]), readData, NULL, lutFlags[l]) != MBMP_STATUS_OK)
+             || (microBmp_initEx(&bmp[1], s_buffer[1], sizeof(s_buffer[1]), readData, NULL, lutFlags[l] | MBMP_INIT_NO_SIMD) != MBMP_STATUS_OK)) {
+          printf("%s: width %u not supported\n", s_formats[f].name, width);
+          ++formatFails;
+          continue;
+        }
+        for (x1 = 0; x1 < width; x1 = (uint16_t)(x1 + 1 + x1 / 4)) {    // all start pixels near the row start (odd nibbles/bits)
+          uint16_t x2;
+          for (x2 = (uint16_t)(x1 + 1); x2 <= width; x2 = (uint16_t)(x2 + 1 + (x2 - x1) / 8)) {
+            formatFails += compareRange(bmp, &s_formats[f], x1, x2);
+            ++ranges;
+          }
+          formatFails += compareRange(bmp, &s_formats[f], x1, width);
+          ++ranges;
+        }
+      }
+      printf("%-10s %-4s %s\n", s_formats[f].name, l ? "lut" : "", formatFails ? "MISMATCH" : "ok");
+      fails += formatFails;
+    }
+  }
+  printf("%d ranges, %d mismatches\n", ranges, fails);
+  return fails != 0;
+}
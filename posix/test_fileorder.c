@@ -0,0 +1,159 @@
+/**
+ * checks that microBmp_getRow, microBmp_getPrevRow, microBmp_getNextRow and microBmp_getNextRows can be mixed,
+ * with and without MBMP_INIT_FILE_ORDER, for bottom up and top down images and for loaded and mapped rows.
+ * Random sequences of the calls are compared with a model of the row they have to return.
+ * Prints the number of failures and returns non zero if there are any.
+ *
+ * build and run on the host:
+ *   gcc -O2 -o test_fileorder test_fileorder.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ *   ./test_fileorder
+ */
+
+#include "../microBmp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH   4
+#define HEIGHT  100
+#define STEPS   4000
+
+static uint8_t s_file[14 + 40 + HEIGHT * WIDTH * 3];
+static uint8_t s_buffer[512];
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+/** writes a 24 bit bmp into s_file, the first two bytes of each row hold its image row */
+static void makeImage(int i_topDown)
+{
+  uint32_t y;
+  memset(s_file, 0, sizeof(s_file));
+  s_file[0] = 'B';
+  s_file[1] = 'M';
+  put32(s_file +  2, sizeof(s_file));
+  put32(s_file + 10, 14 + 40);
+  put32(s_file + 14, 40);
+  put32(s_file + 18, WIDTH);
+  put32(s_file + 22, i_topDown ? (uint32_t)-HEIGHT : HEIGHT);
+  put16(s_file + 26, 1);
+  put16(s_file + 28, 24);
+  for (y = 0; y < HEIGHT; ++y) {
+    uint32_t fileRow = i_topDown ? y : HEIGHT - 1 - y;
+    put16(s_file + 14 + 40 + fileRow * WIDTH * 3, y);
+  }
+}
+
+static void readData(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  (void)io_userData;
+  memset(o_buffer, 0, i_numBytes);
+  if (i_offset < sizeof(s_file)) {
+    memcpy(o_buffer, s_file + i_offset, (i_numBytes < sizeof(s_file) - i_offset) ? i_numBytes : sizeof(s_file) - i_offset);
+  }
+}
+
+static const void* mapData(uint32_t i_offset, uint32_t i_numBytes, void* io_userData)
+{
+  (void)io_userData;
+  if ((i_offset > sizeof(s_file)) || (i_numBytes > sizeof(s_file) - i_offset)) {
+    return NULL;
+  }
+  return s_file + i_offset;
+}
+
+/** compares a returned row with the expected one (-1 - NULL expected), returns 1 on a mismatch */
+static int checkRow(const microBmp_State* i_bmp, const uint8_t* i_row, int i_expected, const char* i_call, int i_step)
+{
+  if ((i_expected < 0) ? (i_row == NULL) : (i_row && (i_row[0] | (i_row[1] << 8)) == i_expected && i_bmp->rowY == i_expected)) {
+    return 0;
+  }
+  printf("  step %d %s: expected row %d, got %d\n", i_step, i_call, i_expected, i_row ? (i_row[0] | (i_row[1] << 8)) : -1);
+  return 1;
+}
+
+/**
+ * runs a random sequence of row calls. The model keeps the row returned last, the walk goes
+ * downwards or upwards (file order of bottom up images), getPrevRow steps back against it.
+ */
+static int runSequence(int i_topDown, uint32_t i_flags, int i_mapped)
+{
+  microBmp_State bmp;
+  int            up    = (i_flags & MBMP_INIT_FILE_ORDER) && !i_topDown;
+  int            dir   = up ? -1 : 1;
+  int            last  = up ? HEIGHT : -1;     // row returned last, one step before the first row of the walk
+  int            fails = 0;
+  int            step;
+  makeImage(i_topDown);
+  if (microBmp_initEx(&bmp, s_buffer, sizeof(s_buffer), readData, NULL, i_flags) != MBMP_STATUS_OK) {
+    printf("  init failed\n");
+    return 1;
+  }
+  if (i_mapped) {
+    microBmp_setMapDataFunc(&bmp, mapData);
+  }
+  for (step = 0; step < STEPS; ++step) {
+    int op = rand() % 8;
+    if (op < 2) {
+      int y = rand() % (HEIGHT + 2);
+      fails += checkRow(&bmp, microBmp_getRow(&bmp, (uint16_t)y), (y < HEIGHT) ? y : -1, "getRow", step);
+      if (y < HEIGHT) {
+        last = y;
+      }
+    } else if (op < 4) {
+      int  expected = last - dir;
+      int  valid    = (last >= 0) && (last < HEIGHT) && (expected >= 0) && (expected < HEIGHT);
+      fails += checkRow(&bmp, microBmp_getPrevRow(&bmp), valid ? expected : -1, "getPrevRow", step);
+      if (valid) {
+        last = expected;
+      }
+    } else if (op < 7) {
+      int  expected = last + dir;
+      int  valid    = (expected >= 0) && (expected < HEIGHT);
+      fails += checkRow(&bmp, microBmp_getNextRow(&bmp), valid ? expected : -1, "getNextRow", step);
+      if (valid) {
+        last = expected;
+      }
+    } else {
+      uint16_t       n;
+      int            expected = last + dir;
+      int            valid    = (expected >= 0) && (expected < HEIGHT);
+      const uint8_t* first    = microBmp_getNextRows(&bmp, (uint16_t)(1 + rand() % 8), &n);
+      if (first && (n > 1)) {
+        first += (int32_t)(n - 1) * bmp.rowStride * (up ? -1 : 1);   // check the last row of the run
+      }
+      fails += checkRow(&bmp, first, valid ? expected + (n - 1) * dir : -1, "getNextRows", step);
+      if (valid) {
+        last = expected + (n - 1) * dir;
+      }
+    }
+    if ((step % 500) == 499) {                    // restart the walk from a random row
+      int y = rand() % HEIGHT;
+      microBmp_setNextRow(&bmp, (uint16_t)y);
+      last = y - dir;
+    }
+  }
+  return fails;
+}
+
+int main(void)
+{
+  static const uint32_t flags[] = { MBMP_INIT_DEFAULT, MBMP_INIT_FILE_ORDER };
+  int    fails = 0;
+  int    topDown, mapped;
+  size_t f;
+  srand(1);
+  for (f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f) {
+    for (topDown = 0; topDown < 2; ++topDown) {
+      for (mapped = 0; mapped < 2; ++mapped) {
+        int n = runSequence(topDown, flags[f], mapped);
+        printf("%-10s %-9s %-6s %s\n", flags[f] ? "file order" : "default", topDown ? "top down" : "bottom up", mapped ? "mapped" : "loaded",
+               n ? "FAILED" : "ok");
+        fails += n;
+      }
+    }
+  }
+  printf("%d failures\n", fails);
+  return fails != 0;
+}
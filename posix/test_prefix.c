@@ -0,0 +1,135 @@
+/**
+ * checks microBmp_initPrefix: the rows of the prefix that are kept as first cache block and the rows loaded later
+ * have to match the file, for prefixes from the file header to the whole file and buffers with 0..MAX_SPARE bytes
+ * more than the prefix (the cases where the headers, palette and lookup tables are read over the kept data).
+ * Prints the number of failures and returns non zero if there are any.
+ *
+ * build and run on the host:
+ *   gcc -O2 -o test_prefix test_prefix.c ../microBmp.c ../microBmp_x86.c ../microBmp_neon.c ../microBmp_swar.c
+ *   ./test_prefix
+ */
+
+#include "../microBmp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SPARE  160
+
+typedef struct {
+  const char* name;
+  uint16_t    width;
+  int32_t     height;         /**< negative - top down */
+  uint16_t    bitsPerPixel;
+  uint32_t    colors;
+} Image;
+
+static const Image s_images[] = {
+  { "4x4 rgb24",          4,   4, 24,   0 },
+  { "4x4 rgb24 top down", 4,  -4, 24,   0 },
+  { "5x6 index8",         5,   6,  8,  16 },
+  { "9x7 index4",         9,   7,  4,  16 },
+  { "13x5 index1",       13,   5,  1,   2 },
+  { "3x9 rgb32",          3,   9, 32,   0 },
+};
+
+static uint8_t  s_file[14 + 40 + 256 * 4 + 16 * 64];
+static uint32_t s_fileSize;
+static uint8_t  s_buffer[sizeof(s_file) + MAX_SPARE];
+
+static void put16(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+/** writes the image with random pixels (and palette) into s_file, returns the offset of the image data */
+static uint32_t makeImage(const Image* i_img)
+{
+  uint32_t rows     = (uint32_t)((i_img->height < 0) ? -i_img->height : i_img->height);
+  uint32_t rowBytes = ((uint32_t)i_img->width * i_img->bitsPerPixel + 31) / 32 * 4;
+  uint32_t offset   = 14 + 40 + i_img->colors * 4;
+  uint32_t i;
+  s_fileSize = offset + rowBytes * rows;
+  memset(s_file, 0, sizeof(s_file));
+  for (i = 14 + 40; i < s_fileSize; ++i) {
+    s_file[i] = (uint8_t)rand();
+  }
+  s_file[0] = 'B';
+  s_file[1] = 'M';
+  put32(s_file +  2, s_fileSize);
+  put32(s_file + 10, offset);
+  put32(s_file + 14, 40);
+  put32(s_file + 18, i_img->width);
+  put32(s_file + 22, (uint32_t)i_img->height);
+  put16(s_file + 26, 1);
+  put16(s_file + 28, i_img->bitsPerPixel);
+  put32(s_file + 30, 0);
+  put32(s_file + 34, 0);
+  put32(s_file + 38, 0);
+  put32(s_file + 42, 0);
+  put32(s_file + 46, i_img->colors);
+  put32(s_file + 50, 0);
+  return offset;
+}
+
+static void readData(void* o_buffer, uint32_t i_numBytes, uint32_t i_offset, void* io_userData)
+{
+  (void)io_userData;
+  memset(o_buffer, 0, i_numBytes);
+  if (i_offset < s_fileSize) {
+    memcpy(o_buffer, s_file + i_offset, (i_numBytes < s_fileSize - i_offset) ? i_numBytes : s_fileSize - i_offset);
+  }
+}
+
+/** compares all rows (in random order and then top to bottom), returns 1 on a mismatch */
+static int checkRows(microBmp_State* io_bmp, const Image* i_img, uint32_t i_offset)
+{
+  uint32_t rows = (uint32_t)((i_img->height < 0) ? -i_img->height : i_img->height);
+  uint32_t pass, k;
+  for (pass = 0; pass < 2; ++pass) {
+    for (k = 0; k < rows; ++k) {
+      uint16_t       y       = (uint16_t)((pass == 0) ? rand() % rows : k);
+      uint32_t       fileRow = (i_img->height < 0) ? y : rows - 1 - y;
+      const uint8_t* row     = microBmp_getRow(io_bmp, y);
+      if (!row || memcmp(row, s_file + i_offset + fileRow * io_bmp->bytesPerRow, io_bmp->bytesPerRow)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int main(void)
+{
+  static const uint32_t lutFlags[] = { 0, MBMP_INIT_PALETTE_LUT_RGB | MBMP_INIT_PALETTE_LUT_565 };
+  int    fails = 0;
+  int    runs  = 0;
+  size_t i, l;
+  srand(1);
+  for (i = 0; i < sizeof(s_images) / sizeof(s_images[0]); ++i) {
+    for (l = 0; l < sizeof(lutFlags) / sizeof(lutFlags[0]); ++l) {
+      uint32_t offset      = makeImage(&s_images[i]);
+      int      imageFails  = 0;
+      uint32_t prefix;
+      for (prefix = 14; prefix <= s_fileSize; ++prefix) {
+        uint32_t spare;
+        for (spare = 0; spare <= MAX_SPARE; ++spare) {
+          microBmp_State bmp;
+          if (microBmp_initPrefix(&bmp, s_buffer, prefix + spare, prefix, readData, NULL, lutFlags[l]) != MBMP_STATUS_OK) {
+            continue;                               // buffer too small for palette, lookup tables and one row
+          }
+          ++runs;
+          if (checkRows(&bmp, &s_images[i], offset)) {
+            if (imageFails < 5) {
+              printf("  %s: prefix %u, %u spare bytes: rows differ from the file\n", s_images[i].name, prefix, spare);
+            }
+            ++imageFails;
+          }
+        }
+      }
+      printf("%-20s %-4s %s\n", s_images[i].name, l ? "lut" : "", imageFails ? "FAILED" : "ok");
+      fails += imageFails;
+    }
+  }
+  printf("%d runs, %d failures\n", runs, fails);
+  return fails != 0;
+}